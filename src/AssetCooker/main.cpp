@@ -0,0 +1,216 @@
+// Офлайн-подготовка моделей: обходит каталог, импортирует файлы параллельно,
+// сваривает и переупорядочивает геометрию и пишет бинарный кэш (.tmc),
+// который просмотрщик затем читает вместо повторного импорта.
+//
+// Использование: AssetCooker <входной каталог> [выходной каталог] [--force]
+// Без выходного каталога кэш кладётся рядом с исходниками - там его ищет ModelParser.
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include <assimp/Importer.hpp>
+#include "../Core/parser.h"
+#include "../Core/meshbinary.h"
+#include "../Core/threadpool.h"
+
+namespace fs = std::filesystem;
+
+enum class CookStatus {
+    COOKED,
+    SKIPPED,
+    ANIMATED,
+    FAILED
+};
+
+struct CookResult {
+    std::string source;
+    CookStatus status;
+    uint64_t sourceBytes;
+    uint64_t cookedBytes;
+    size_t meshes;
+    size_t triangles;
+    double ms;
+};
+
+static const char* statusName(CookStatus status) {
+    switch (status) {
+        case CookStatus::COOKED: return "cooked";
+        case CookStatus::SKIPPED: return "up to date";
+        case CookStatus::ANIMATED: return "animated";
+        default: return "FAILED";
+    }
+}
+
+static std::vector<fs::path> collectModels(const fs::path& root) {
+    Assimp::Importer importer;
+    std::vector<fs::path> files;
+
+    std::error_code error;
+    for (fs::recursive_directory_iterator it(root, error), end; it != end; it.increment(error)) {
+        if (error) break;
+        if (!it->is_regular_file()) continue;
+
+        std::string extension = it->path().extension().string();
+        if (extension.empty() || extension == ".tmc") continue;
+        if (importer.IsExtensionSupported(extension)) {
+            files.push_back(it->path());
+        }
+    }
+
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+static CookResult cookFile(const fs::path& source, const fs::path& inputRoot, const fs::path& outputRoot, bool force) {
+    auto start = std::chrono::steady_clock::now();
+    CookResult result = {source.string(), CookStatus::FAILED, 0, 0, 0, 0, 0.0};
+
+    fs::path output = outputRoot.empty()
+        ? fs::path(MeshBinaryCache::getCachePath(source.string()))
+        : outputRoot / fs::path(MeshBinaryCache::getCachePath(fs::relative(source, inputRoot).string()));
+
+    // Свой кэш парсера не нужен - результат пишется в выходной каталог.
+    // Настройки импорта - те же, что у просмотрщика по умолчанию: их отпечаток входит в ключ кэша
+    ModelParser parser;
+    parser.setUseBinaryCache(false);
+    parser.setVerbose(false);
+
+    uint64_t sourceHash = 0, sourceSize = 0;
+    if (MeshBinaryCache::hashFile(source.string(), sourceHash, sourceSize)) {
+        result.sourceBytes = sourceSize;
+
+        if (!force && MeshBinaryCache::isUpToDate(output.string(), sourceHash, sourceSize, parser.getCacheOptionsHash())) {
+            result.status = CookStatus::SKIPPED;
+        } else {
+            bool loaded = parser.loadModel(source.string());
+            if (loaded && parser.isAnimated()) {
+                // Кэш не хранит кости и клипы - такие модели просмотрщик импортирует сам
+                result.status = CookStatus::ANIMATED;
+            } else if (loaded) {
+                std::error_code error;
+                fs::create_directories(output.parent_path(), error);
+
+                const auto& meshes = parser.getMeshes();
+                if (MeshBinaryCache::save(output.string(), sourceHash, sourceSize, parser.getCacheOptionsHash(),
+                                          meshes, parser.getSceneGraph())) {
+                    result.status = CookStatus::COOKED;
+                    result.meshes = meshes.size();
+                    for (const auto& mesh : meshes) result.triangles += mesh.baseIndexCount() / 3;
+                }
+            }
+        }
+    }
+
+    std::error_code error;
+    uint64_t cookedSize = fs::exists(output, error) ? (uint64_t)fs::file_size(output, error) : 0;
+    result.cookedBytes = error ? 0 : cookedSize;
+    result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+static void printTable(const std::vector<CookResult>& results, double totalMs) {
+    const double MB = 1024.0 * 1024.0;
+
+    std::cout << "\n" << std::left << std::setw(40) << "File"
+              << std::right << std::setw(12) << "Status"
+              << std::setw(10) << "Src MB"
+              << std::setw(10) << "Out MB"
+              << std::setw(8) << "Meshes"
+              << std::setw(12) << "Triangles"
+              << std::setw(10) << "ms"
+              << std::setw(10) << "MB/s" << std::endl;
+
+    uint64_t totalSource = 0, cookedSource = 0;
+    size_t cooked = 0, skipped = 0, animated = 0, failed = 0;
+    for (const CookResult& r : results) {
+        std::string name = fs::path(r.source).filename().string();
+        if (name.size() > 38) name = name.substr(0, 35) + "...";
+
+        double throughput = r.ms > 0.0 ? (r.sourceBytes / MB) / (r.ms / 1000.0) : 0.0;
+        std::cout << std::left << std::setw(40) << name
+                  << std::right << std::setw(12) << statusName(r.status)
+                  << std::fixed << std::setprecision(2)
+                  << std::setw(10) << r.sourceBytes / MB
+                  << std::setw(10) << r.cookedBytes / MB
+                  << std::setw(8) << r.meshes
+                  << std::setw(12) << r.triangles
+                  << std::setprecision(1)
+                  << std::setw(10) << r.ms
+                  << std::setw(10) << (r.status == CookStatus::COOKED ? throughput : 0.0) << std::endl;
+
+        totalSource += r.sourceBytes;
+        if (r.status == CookStatus::COOKED) {
+            cooked++;
+            cookedSource += r.sourceBytes;
+        } else if (r.status == CookStatus::SKIPPED) {
+            skipped++;
+        } else if (r.status == CookStatus::ANIMATED) {
+            animated++;
+        } else {
+            failed++;
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "\nCooked " << cooked << ", up to date " << skipped << ", animated (not cached) " << animated << ", failed " << failed
+              << " of " << results.size() << " files (" << totalSource / MB << " MB) in " << totalMs << " ms, "
+              << (totalMs > 0.0 ? (cookedSource / MB) / (totalMs / 1000.0) : 0.0) << " MB/s on "
+              << ThreadPool::shared().getThreadCount() + 1 << " threads" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    fs::path input;
+    fs::path output;
+    bool force = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--force") {
+            force = true;
+        } else if (input.empty()) {
+            input = arg;
+        } else if (output.empty()) {
+            output = arg;
+        }
+    }
+
+    if (input.empty() || !fs::is_directory(input)) {
+        std::cout << "Usage: AssetCooker <input directory> [output directory] [--force]" << std::endl;
+        return 1;
+    }
+
+    std::vector<fs::path> files = collectModels(input);
+    if (files.empty()) {
+        std::cout << "No supported models in " << input.string() << std::endl;
+        return 0;
+    }
+    std::cout << "Cooking " << files.size() << " files from " << input.string() << std::endl;
+
+    // Файлы раздаются потокам пула по одному; импорт внутри файла тоже параллелен
+    std::vector<CookResult> results(files.size());
+    std::mutex printMutex;
+    size_t finished = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    ThreadPool::shared().parallelFor(files.size(), [&](size_t i) {
+        results[i] = cookFile(files[i], input, output, force);
+
+        std::lock_guard<std::mutex> lock(printMutex);
+        finished++;
+        std::cout << "[" << finished << "/" << files.size() << "] " << statusName(results[i].status)
+                  << ": " << files[i].string() << std::endl;
+    });
+
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printTable(results, totalMs);
+
+    for (const CookResult& r : results) {
+        if (r.status == CookStatus::FAILED) return 2;
+    }
+    return 0;
+}
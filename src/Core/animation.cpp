@@ -0,0 +1,255 @@
+#include "animation.h"
+#include <cmath>
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+
+static const float QUAT_RANGE = 0.70710678f; // |компонента| кроме наибольшей не больше 1/sqrt2
+static const uint32_t QUAT_MAX = 32767;
+static const float TIME_MAX = 65535.0f;
+static const size_t MAX_REDUCED_SPAN = 1024; // ограничивает квадратичную проверку на длинных дорожках
+
+static PackedQuat packQuat(const glm::quat& q) {
+    float c[4] = {q.x, q.y, q.z, q.w};
+    unsigned int largest = 0;
+    for (unsigned int i = 1; i < 4; i++) {
+        if (std::fabs(c[i]) > std::fabs(c[largest])) largest = i;
+    }
+    // q и -q - одно вращение: наибольшая компонента всегда положительна и не хранится
+    float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+
+    uint16_t packed[3];
+    for (unsigned int i = 0, j = 0; i < 4; i++) {
+        if (i == largest) continue;
+        float unit = std::min(1.0f, std::max(0.0f, (c[i] * sign / QUAT_RANGE) * 0.5f + 0.5f));
+        packed[j++] = (uint16_t)std::lround(unit * QUAT_MAX);
+    }
+    PackedQuat result;
+    result.bits[0] = (uint16_t)(packed[0] | ((largest >> 1) << 15));
+    result.bits[1] = (uint16_t)(packed[1] | ((largest & 1) << 15));
+    result.bits[2] = packed[2];
+    return result;
+}
+
+static glm::quat unpackQuat(const PackedQuat& packed) {
+    unsigned int largest = ((packed.bits[0] >> 15) << 1) | (packed.bits[1] >> 15);
+    float c[4];
+    float sum = 0.0f;
+    for (unsigned int i = 0, j = 0; i < 4; i++) {
+        if (i == largest) continue;
+        float value = ((packed.bits[j++] & QUAT_MAX) * (2.0f / QUAT_MAX) - 1.0f) * QUAT_RANGE;
+        c[i] = value;
+        sum += value * value;
+    }
+    c[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+    return glm::quat(c[3], c[0], c[1], c[2]);
+}
+
+// Угол между вращениями; через длину разности точнее, чем acos скалярного произведения у единицы
+static float rotationDistance(const glm::quat& a, const glm::quat& b) {
+    glm::quat aligned = glm::dot(a, b) < 0.0f ? -b : b;
+    return 2.0f * glm::length(a - aligned);
+}
+
+static float vectorDistance(const glm::vec3& a, const glm::vec3& b) {
+    glm::vec3 d = glm::abs(a - b);
+    return std::max(d.x, std::max(d.y, d.z));
+}
+
+static glm::vec3 interpolate(const VectorKey& a, const VectorKey& b, float time) {
+    float span = b.time - a.time;
+    return glm::mix(a.value, b.value, span > 0.0f ? (time - a.time) / span : 0.0f);
+}
+
+static glm::quat interpolate(const RotationKey& a, const RotationKey& b, float time) {
+    float span = b.time - a.time;
+    return glm::slerp(a.value, b.value, span > 0.0f ? (time - a.time) / span : 0.0f);
+}
+
+static float distance(const glm::vec3& a, const glm::vec3& b) { return vectorDistance(a, b); }
+static float distance(const glm::quat& a, const glm::quat& b) { return rotationDistance(a, b); }
+
+// Индексы ключей, которые нужно оставить: от опорного ключа дорожка тянется вперёд, пока
+// интерполяция до кандидата восстанавливает все пропущенные ключи с ошибкой не больше tolerance
+template <typename Key>
+static void reduceKeys(const std::vector<Key>& keys, float tolerance, std::vector<uint32_t>& kept) {
+    kept.clear();
+    kept.push_back(0);
+
+    bool constant = true;
+    for (size_t k = 1; k < keys.size() && constant; k++) {
+        constant = distance(keys[k].value, keys[0].value) <= tolerance;
+    }
+    if (constant) return;
+
+    size_t anchor = 0;
+    for (size_t end = 2; end < keys.size(); end++) {
+        bool fits = end - anchor <= MAX_REDUCED_SPAN;
+        for (size_t k = anchor + 1; k < end && fits; k++) {
+            fits = distance(interpolate(keys[anchor], keys[end], keys[k].time), keys[k].value) <= tolerance;
+        }
+        if (!fits) {
+            anchor = end - 1;
+            kept.push_back((uint32_t)anchor);
+        }
+    }
+    kept.push_back((uint32_t)keys.size() - 1);
+}
+
+static uint16_t quantizeTime(float time, float timeStep) {
+    return (uint16_t)std::lround(std::min(TIME_MAX, std::max(0.0f, time / timeStep)));
+}
+
+static float vectorTolerance(const std::vector<VectorKey>& keys, float error) {
+    float extent = 0.0f;
+    for (const VectorKey& key : keys) {
+        extent = std::max(extent, vectorDistance(key.value, glm::vec3(0.0f)));
+    }
+    return error * std::max(1.0f, extent);
+}
+
+static void appendVectorTrack(const std::vector<VectorKey>& keys, float tolerance, AnimationClip& clip,
+                              std::vector<uint32_t>& kept) {
+    reduceKeys(keys, tolerance, kept);
+    clip.tracks.push_back(AnimationTrack{(uint32_t)clip.vectorKeys.size(), (uint32_t)kept.size()});
+    for (uint32_t k : kept) {
+        clip.vectorTimes.push_back(quantizeTime(keys[k].time, clip.timeStep));
+        clip.vectorKeys.push_back(keys[k].value);
+    }
+}
+
+void AnimationCompressor::compress(const RawAnimationClip& source, const AnimationCompression& settings, AnimationClip& clip) {
+    clip.name = source.name;
+    clip.duration = source.duration;
+    clip.nodes.clear();
+    clip.tracks.clear();
+    clip.vectorTimes.clear();
+    clip.vectorKeys.clear();
+    clip.rotationTimes.clear();
+    clip.rotationKeys.clear();
+    clip.sourceKeys = 0;
+    clip.sourceBytes = 0;
+
+    // Ключи после конца клипа встречаются - шкала времени покрывает и их
+    float end = source.duration;
+    for (const RawAnimationChannel& channel : source.channels) {
+        end = std::max(end, channel.positions.back().time);
+        end = std::max(end, channel.rotations.back().time);
+        end = std::max(end, channel.scales.back().time);
+    }
+    clip.timeStep = end > 0.0f ? end / TIME_MAX : 1.0f;
+
+    std::vector<uint32_t> kept;
+    std::vector<RotationKey> rotations;
+    for (const RawAnimationChannel& channel : source.channels) {
+        clip.nodes.push_back(channel.node);
+        clip.sourceKeys += channel.positions.size() + channel.rotations.size() + channel.scales.size();
+        clip.sourceBytes += (channel.positions.size() + channel.scales.size()) * sizeof(VectorKey) +
+                            channel.rotations.size() * sizeof(RotationKey);
+
+        appendVectorTrack(channel.positions, vectorTolerance(channel.positions, settings.positionError), clip, kept);
+
+        // Соседние кватернионы в одной полусфере - иначе прореживание видит ложные скачки
+        rotations = channel.rotations;
+        for (size_t k = 0; k < rotations.size(); k++) {
+            rotations[k].value = glm::normalize(rotations[k].value);
+            if (k > 0 && glm::dot(rotations[k - 1].value, rotations[k].value) < 0.0f) {
+                rotations[k].value = -rotations[k].value;
+            }
+        }
+        reduceKeys(rotations, settings.rotationError, kept);
+        clip.tracks.push_back(AnimationTrack{(uint32_t)clip.rotationKeys.size(), (uint32_t)kept.size()});
+        for (uint32_t k : kept) {
+            clip.rotationTimes.push_back(quantizeTime(rotations[k].time, clip.timeStep));
+            clip.rotationKeys.push_back(packQuat(rotations[k].value));
+        }
+
+        appendVectorTrack(channel.scales, settings.scaleError, clip, kept);
+    }
+}
+
+size_t AnimationClip::byteSize() const {
+    return nodes.size() * sizeof(uint32_t) + tracks.size() * sizeof(AnimationTrack) +
+           vectorTimes.size() * sizeof(uint16_t) + vectorKeys.size() * sizeof(glm::vec3) +
+           rotationTimes.size() * sizeof(uint16_t) + rotationKeys.size() * sizeof(PackedQuat);
+}
+
+// Ключ, начинающий интервал с unit. От подсказки сначала несколько шагов вперёд -
+// при проигрывании следующий ключ почти всегда рядом; иначе двоичный поиск
+static uint32_t seekKey(const uint16_t* times, uint32_t count, float unit, uint32_t hint) {
+    if (count < 2 || unit <= times[0]) return 0;
+
+    if (hint < count && unit >= times[hint]) {
+        for (int step = 0; step < 4; step++) {
+            if (hint + 1 >= count || unit < times[hint + 1]) return hint;
+            hint++;
+        }
+    }
+    const uint16_t* next = std::upper_bound(times, times + count, unit,
+                                            [](float u, uint16_t t) { return u < (float)t; });
+    return (uint32_t)(next - times) - 1;
+}
+
+static float keyFraction(const uint16_t* times, uint32_t count, uint32_t key, float unit) {
+    if (key + 1 >= count) return 0.0f;
+    float span = (float)(times[key + 1] - times[key]);
+    if (span <= 0.0f) return 0.0f;
+    return std::min(1.0f, std::max(0.0f, (unit - times[key]) / span));
+}
+
+static glm::vec3 sampleVector(const AnimationClip& clip, const AnimationTrack& track, float unit, uint32_t& cursor) {
+    const uint16_t* times = clip.vectorTimes.data() + track.firstKey;
+    const glm::vec3* keys = clip.vectorKeys.data() + track.firstKey;
+    cursor = seekKey(times, track.keyCount, unit, cursor);
+    float fraction = keyFraction(times, track.keyCount, cursor, unit);
+    if (fraction == 0.0f) return keys[cursor];
+    return glm::mix(keys[cursor], keys[cursor + 1], fraction);
+}
+
+static glm::quat sampleRotation(const AnimationClip& clip, const AnimationTrack& track, float unit, uint32_t& cursor) {
+    const uint16_t* times = clip.rotationTimes.data() + track.firstKey;
+    const PackedQuat* keys = clip.rotationKeys.data() + track.firstKey;
+    cursor = seekKey(times, track.keyCount, unit, cursor);
+    float fraction = keyFraction(times, track.keyCount, cursor, unit);
+    if (fraction == 0.0f) return unpackQuat(keys[cursor]);
+    return glm::slerp(unpackQuat(keys[cursor]), unpackQuat(keys[cursor + 1]), fraction);
+}
+
+// cursors - по ключу на дорожку; на выходе ключи, найденные для time
+static void sampleClip(const AnimationClip& clip, float time, SceneGraph& sceneGraph, uint32_t* cursors) {
+    if (clip.duration > 0.0f) {
+        time = std::fmod(time, clip.duration);
+        if (time < 0.0f) time += clip.duration;
+    }
+    float unit = time / clip.timeStep;
+
+    for (size_t c = 0; c < clip.nodes.size(); c++) {
+        uint32_t node = clip.nodes[c];
+        if (node >= sceneGraph.getNodeCount()) continue;
+
+        const AnimationTrack* tracks = &clip.tracks[c * 3];
+        uint32_t* cursor = &cursors[c * 3];
+        glm::vec3 position = sampleVector(clip, tracks[0], unit, cursor[0]);
+        glm::quat rotation = sampleRotation(clip, tracks[1], unit, cursor[1]);
+        glm::vec3 scale = sampleVector(clip, tracks[2], unit, cursor[2]);
+
+        glm::mat4 local = glm::mat4_cast(rotation);
+        local[0] *= scale.x;
+        local[1] *= scale.y;
+        local[2] *= scale.z;
+        local[3] = glm::vec4(position, 1.0f);
+        sceneGraph.setLocalTransform(node, local);
+    }
+}
+
+void AnimationSampler::sample(const AnimationClip& clip, float time, SceneGraph& sceneGraph) {
+    std::vector<uint32_t> cursors(clip.tracks.size(), 0);
+    sampleClip(clip, time, sceneGraph, cursors.data());
+}
+
+void AnimationCursor::sample(const AnimationClip& source, float time, SceneGraph& sceneGraph) {
+    if (clip != &source || keys.size() != source.tracks.size()) {
+        clip = &source;
+        keys.assign(source.tracks.size(), 0);
+    }
+    sampleClip(source, time, sceneGraph, keys.data());
+}
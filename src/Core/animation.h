@@ -0,0 +1,105 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "scenegraph.h"
+
+struct VectorKey {
+    float time; // секунды
+    glm::vec3 value;
+};
+
+struct RotationKey {
+    float time;
+    glm::quat value;
+};
+
+// Ключи одного узла в том виде, в каком они пришли из файла. Каждая дорожка содержит
+// хотя бы один ключ: неанимированная компонента хранится одним ключом со значением bind-позы
+struct RawAnimationChannel {
+    uint32_t node;
+    std::vector<VectorKey> positions;
+    std::vector<RotationKey> rotations;
+    std::vector<VectorKey> scales;
+};
+
+struct RawAnimationClip {
+    std::string name;
+    float duration; // секунды
+    std::vector<RawAnimationChannel> channels;
+};
+
+// Допуски прореживания ключей: выброшенный ключ восстанавливается интерполяцией соседей
+// с ошибкой не больше заданной
+struct AnimationCompression {
+    float positionError; // доля от размаха дорожки, но не меньше абсолютной величины
+    float rotationError; // радианы
+    float scaleError;
+
+    AnimationCompression() : positionError(1e-4f), rotationError(1e-3f), scaleError(1e-4f) {}
+};
+
+// Кватернион "smallest three": индекс наибольшей компоненты (2 бита в старших битах
+// первых двух слов) и остальные три по 15 бит в [-1/sqrt2, 1/sqrt2]
+struct PackedQuat {
+    uint16_t bits[3];
+};
+
+// Дорожка - отрезок общего пула ключей. Постоянная дорожка хранит один ключ
+struct AnimationTrack {
+    uint32_t firstKey;
+    uint32_t keyCount;
+};
+
+// Сжатый клип. На канал приходится три дорожки подряд: позиция, вращение, масштаб.
+// Позиции и масштабы лежат в одном пуле, вращения - в другом; время ключа квантовано в 16 бит
+struct AnimationClip {
+    std::string name;
+    float duration;  // секунды
+    float timeStep;  // секунд на единицу квантованного времени
+    std::vector<uint32_t> nodes;
+    std::vector<AnimationTrack> tracks;
+    std::vector<uint16_t> vectorTimes;
+    std::vector<glm::vec3> vectorKeys;
+    std::vector<uint16_t> rotationTimes;
+    std::vector<PackedQuat> rotationKeys;
+    size_t sourceKeys;  // ключей до сжатия - для отчёта
+    size_t sourceBytes;
+
+    size_t channelCount() const { return nodes.size(); }
+    size_t keyCount() const { return vectorKeys.size() + rotationKeys.size(); }
+    size_t byteSize() const;
+};
+
+class AnimationCompressor {
+public:
+    // Убирает постоянные дорожки, прореживает ключи в пределах допусков и квантует вращения и время
+    static void compress(const RawAnimationClip& source, const AnimationCompression& settings, AnimationClip& clip);
+};
+
+// Сэмплирование без состояния: двоичный поиск ключа в каждой дорожке
+class AnimationSampler {
+public:
+    // Записывает локальные матрицы анимированных узлов в момент time; клип зациклен
+    static void sample(const AnimationClip& clip, float time, SceneGraph& sceneGraph);
+};
+
+// Сэмплирование с курсором: помнит ключ каждой дорожки с прошлого вызова, так что при
+// проигрывании вперёд поиск ключа стоит O(1). Скачок назад (в том числе на петле) - двоичный поиск
+class AnimationCursor {
+public:
+    AnimationCursor() : clip(nullptr) {}
+
+    void reset() { clip = nullptr; }
+    void sample(const AnimationClip& clip, float time, SceneGraph& sceneGraph);
+
+private:
+    const AnimationClip* clip;
+    std::vector<uint32_t> keys; // текущий ключ каждой дорожки
+};
+
+#endif
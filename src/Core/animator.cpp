@@ -0,0 +1,106 @@
+#include "animator.h"
+#include "skinning.h"
+#include "threadpool.h"
+#include "importprofile.h"
+#include <sstream>
+#include <algorithm>
+#include <iomanip>
+
+struct SkinningJob {
+    size_t mesh;
+    size_t begin;
+    size_t end;
+};
+
+Animator::Animator()
+    : boundModel(nullptr), boundMeshCount(0), clip(0), time(0.0f), speed(1.0f), playing(true), stats() {}
+
+void Animator::bind(const ModelParser& model) {
+    const std::vector<StandardMesh>& meshes = model.getMeshes();
+    boundModel = &model;
+    boundMeshCount = meshes.size();
+    clip = 0;
+    time = 0.0f;
+    cursor.reset();
+
+    meshNodes.assign(meshes.size(), 0);
+    std::vector<char> placed(meshes.size(), 0);
+    for (const MeshInstance& instance : model.getSceneGraph().getMeshInstances()) {
+        if (instance.mesh < meshes.size() && !placed[instance.mesh]) {
+            meshNodes[instance.mesh] = instance.node;
+            placed[instance.mesh] = 1;
+        }
+    }
+
+    palettes.assign(meshes.size(), std::vector<glm::mat4>());
+    skinnedVertices.assign(meshes.size(), std::vector<StandardVertex>());
+    for (size_t i = 0; i < meshes.size(); i++) {
+        if (!meshes[i].skin.empty()) skinnedVertices[i].resize(meshes[i].vertexCount());
+    }
+}
+
+void Animator::update(ModelParser& model, float deltaSeconds) {
+    if (boundModel != &model || boundMeshCount != model.getMeshes().size()) {
+        bind(model);
+    }
+
+    StageSample sample;
+    stats = SkinningStats();
+    SceneGraph& sceneGraph = model.getSceneGraph();
+    const std::vector<AnimationClip>& clips = model.getAnimations();
+    if (playing && clip < clips.size()) {
+        time += deltaSeconds * speed;
+        StageSample clipSample;
+        cursor.sample(clips[clip], time, sceneGraph);
+        stats.sampleMs = clipSample.elapsedMs();
+        stats.channels = clips[clip].channelCount();
+    }
+    sceneGraph.updateWorldTransforms();
+
+    // Вершины всех скинированных мешей режутся на диапазоны и раздаются пулу одним списком,
+    // чтобы сотня мелких персонажей загружала потоки так же, как один большой
+    const std::vector<StandardMesh>& meshes = model.getMeshes();
+    std::vector<SkinningJob> jobs;
+    for (size_t i = 0; i < meshes.size(); i++) {
+        const StandardMesh& mesh = meshes[i];
+        if (mesh.skin.empty() || mesh.bones.empty()) continue;
+
+        CpuSkinner::computePalette(mesh, sceneGraph, sceneGraph.getWorldTransform(meshNodes[i]), palettes[i]);
+        for (size_t begin = 0; begin < mesh.vertexCount(); begin += CpuSkinner::RANGE_VERTICES) {
+            jobs.push_back(SkinningJob{i, begin, std::min(mesh.vertexCount(), begin + CpuSkinner::RANGE_VERTICES)});
+        }
+        stats.meshes++;
+        stats.vertices += mesh.vertexCount();
+    }
+
+    ThreadPool& pool = ThreadPool::shared();
+    pool.parallelFor(jobs.size(), [&](size_t j) {
+        const SkinningJob& job = jobs[j];
+        CpuSkinner::skinRange(meshes[job.mesh], palettes[job.mesh].data(), skinnedVertices[job.mesh].data(),
+                              job.begin, job.end);
+    });
+
+    stats.ms = sample.elapsedMs();
+    stats.threads = pool.getThreadCount() + 1;
+}
+
+void Animator::upload(GpuMeshCache& cache, const ModelParser& model) const {
+    if (boundModel != &model) return;
+
+    const std::vector<StandardMesh>& meshes = model.getMeshes();
+    for (size_t i = 0; i < meshes.size() && i < skinnedVertices.size(); i++) {
+        if (skinnedVertices[i].empty()) continue;
+        cache.updateVertices(meshes[i], skinnedVertices[i].data(), skinnedVertices[i].size());
+    }
+}
+
+std::string Animator::summary() const {
+    double seconds = stats.ms / 1000.0;
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2)
+        << "Sampling: " << stats.channels << " channels in " << stats.sampleMs * 1000.0 << " us ("
+        << (stats.sampleMs > 0.0 ? stats.channels / stats.sampleMs / 1000.0 : 0.0) << " Mchannels/s), "
+        << "skinning: " << stats.meshes << " meshes, " << stats.vertices << " vertices in " << stats.ms << " ms ("
+        << (seconds > 0.0 ? stats.vertices / seconds / 1e6 : 0.0) << " Mverts/s on " << stats.threads << " threads)";
+    return out.str();
+}
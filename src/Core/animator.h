@@ -0,0 +1,61 @@
+#ifndef ANIMATOR_H
+#define ANIMATOR_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "parser.h"
+#include "gpumesh.h"
+
+struct SkinningStats {
+    size_t channels;
+    double sampleMs; // сэмплирование клипа в граф сцены
+    size_t meshes;
+    size_t vertices;
+    double ms; // сэмплирование, палитры и скинирование за кадр
+    size_t threads;
+};
+
+// Проигрывание клипов модели и CPU-скинирование её мешей. update() не требует
+// GL-контекста - его можно гонять на машине без GPU; upload() переписывает
+// вершинные буферы уже загруженных мешей.
+class Animator {
+public:
+    Animator();
+
+    void setClip(size_t index) { clip = index; time = 0.0f; cursor.reset(); }
+    size_t getClip() const { return clip; }
+    void setPlaying(bool enabled) { playing = enabled; }
+    bool isPlaying() const { return playing; }
+    void setSpeed(float factor) { speed = factor; }
+
+    // Забывает привязку к модели - после смены сцены, даже если она легла по тому же адресу
+    void reset() { boundModel = nullptr; cursor.reset(); }
+
+    // Сдвигает время, сэмплирует клип в граф сцены и скинирует меши. Новая модель сбрасывает состояние
+    void update(ModelParser& model, float deltaSeconds);
+    void upload(GpuMeshCache& cache, const ModelParser& model) const;
+
+    const std::vector<StandardVertex>& getSkinnedVertices(size_t mesh) const { return skinnedVertices[mesh]; }
+    const SkinningStats& getStats() const { return stats; }
+    std::string summary() const;
+
+private:
+    void bind(const ModelParser& model);
+
+    const ModelParser* boundModel;
+    size_t boundMeshCount;
+    size_t clip;
+    float time;
+    float speed;
+    bool playing;
+    AnimationCursor cursor;
+
+    std::vector<uint32_t> meshNodes; // узел первого экземпляра меша - пространство скинирования
+    std::vector<std::vector<glm::mat4>> palettes;
+    std::vector<std::vector<StandardVertex>> skinnedVertices;
+    SkinningStats stats;
+};
+
+#endif
@@ -0,0 +1,199 @@
+#include "asyncloader.h"
+#include <iostream>
+#include <chrono>
+
+AsyncModelLoader::AsyncModelLoader(size_t queueCapacity)
+    : uploadQueue(queueCapacity),
+      hotReload(false),
+      reloadRequested(false),
+      lastSwapWasReload(false),
+      state(LoadState::IDLE),
+      parseFinished(false),
+      parseSucceeded(false),
+      meshTotal(0),
+      meshesParsed(0),
+      meshesUploaded(0) {}
+
+AsyncModelLoader::~AsyncModelLoader() {
+    // Разблокируем производителей, которые ждут места в очереди
+    uploadQueue.close();
+    waitForWorker();
+}
+
+void AsyncModelLoader::waitForWorker() {
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+bool AsyncModelLoader::requestLoad(const std::string& path) {
+    if (isLoading()) {
+        std::cout << "Model is still loading: " << pendingPath << std::endl;
+        return false;
+    }
+    waitForWorker();
+
+    pendingPath = path;
+    pendingScene = std::make_shared<ModelParser>();
+    parseFinished = false;
+    parseSucceeded = false;
+    meshTotal = 0;
+    meshesParsed = 0;
+    meshesUploaded = 0;
+    uploadQueue.reopen();
+    reusedMeshes.clear();
+    residentByHash.clear();
+    uploadProfile.reset(path);
+    if (currentScene) {
+        for (const auto& mesh : currentScene->getMeshes()) {
+            if (mesh.contentHash != 0) residentByHash.emplace(mesh.contentHash, &mesh);
+        }
+    }
+    state = LoadState::LOADING;
+
+    std::shared_ptr<ModelParser> parser = pendingScene;
+    ModelParser* target = parser.get();
+    parser->setMeshReadyCallback([this, target](size_t meshIndex, size_t meshCount) {
+        meshTotal = meshCount;
+        meshesParsed++;
+        uploadQueue.push(&target->getMeshes()[meshIndex]);
+    });
+
+    worker = std::thread([this, parser, path]() {
+        bool success = parser->loadModel(path);
+        if (success) {
+            meshTotal = parser->getMeshes().size();
+        }
+        parseSucceeded = success;
+        parseFinished = true;
+    });
+
+    std::cout << "Loading model in background: " << path << std::endl;
+    return true;
+}
+
+void AsyncModelLoader::setHotReload(bool enabled) {
+    hotReload = enabled;
+    if (!hotReload && !currentPath.empty()) {
+        watcher.unwatch(currentPath);
+    } else if (hotReload && !currentPath.empty()) {
+        watcher.watch(currentPath);
+    }
+}
+
+void AsyncModelLoader::pollFileChanges() {
+    if (!hotReload || currentPath.empty()) return;
+
+    for (const std::string& path : watcher.poll()) {
+        if (path == currentPath) reloadRequested = true;
+    }
+
+    // Изменение во время загрузки не теряем - перезагрузим после неё
+    if (reloadRequested && !isLoading()) {
+        reloadRequested = false;
+        std::cout << "Model changed on disk, reloading: " << currentPath << std::endl;
+        std::string path = currentPath;
+        requestLoad(path);
+    }
+}
+
+const StandardMesh* AsyncModelLoader::takeResident(const StandardMesh& mesh, const GpuMeshCache& cache) {
+    if (mesh.contentHash == 0) return nullptr;
+
+    auto range = residentByHash.equal_range(mesh.contentHash);
+    for (auto it = range.first; it != range.second; ++it) {
+        const StandardMesh* resident = it->second;
+        if (resident->vertexCount() == mesh.vertexCount() && resident->indexCount() == mesh.indexCount() &&
+            cache.getHandle(*resident) != INVALID_MESH_HANDLE) {
+            residentByHash.erase(it);
+            return resident;
+        }
+    }
+    return nullptr;
+}
+
+bool AsyncModelLoader::pump(Renderer& renderer, double budgetMs) {
+    pollFileChanges();
+    if (state.load() != LoadState::LOADING) return false;
+
+    auto start = std::chrono::steady_clock::now();
+    const StandardMesh* mesh = nullptr;
+    while (uploadQueue.tryPop(mesh)) {
+        // Неизменённый меш уже на GPU - handle перейдёт к нему при переключении сцены
+        const StandardMesh* resident = takeResident(*mesh, renderer.getMeshCache());
+        if (resident) {
+            reusedMeshes.emplace_back(resident, mesh);
+        } else {
+            StageSample uploadSample;
+            const GpuMesh* gpuMesh = renderer.getMeshCache().get(renderer.getMeshCache().upload(*mesh));
+            uploadProfile.record(ImportStage::GPU_UPLOAD, uploadSample,
+                                 gpuMesh ? gpuMesh->vertexBytes + gpuMesh->indexBytes + gpuMesh->tangentBytes : 0);
+        }
+        meshesUploaded++;
+
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed >= budgetMs) break;
+    }
+
+    if (!parseFinished) return false;
+
+    if (!parseSucceeded) {
+        waitForWorker();
+        uploadQueue.close();
+        if (pendingScene) renderer.evictModel(*pendingScene);
+        pendingScene.reset();
+        reusedMeshes.clear();
+        residentByHash.clear();
+        state = LoadState::FAILED;
+        std::cout << "Failed to load model: " << pendingPath << std::endl;
+        return false;
+    }
+
+    if (meshesUploaded.load() < meshTotal.load()) return false;
+
+    // Новая сцена полностью на GPU - переключаемся между кадрами
+    waitForWorker();
+    pendingScene->getImportProfile().merge(ImportStage::GPU_UPLOAD, uploadProfile.getStage(ImportStage::GPU_UPLOAD));
+    std::shared_ptr<ModelParser> previous = currentScene;
+    currentScene = pendingScene;
+    pendingScene.reset();
+    currentScene->setMeshReadyCallback(nullptr);
+
+    size_t reused = 0;
+    for (const auto& pair : reusedMeshes) {
+        if (renderer.getMeshCache().rebind(*pair.first, *pair.second)) reused++;
+    }
+    reusedMeshes.clear();
+    residentByHash.clear();
+
+    // Перепривязанные меши остались без handle у старой сцены и не удаляются
+    if (previous) {
+        renderer.evictModel(*previous);
+    }
+
+    lastSwapWasReload = previous && pendingPath == currentPath;
+    if (pendingPath != currentPath) {
+        if (!currentPath.empty()) watcher.unwatch(currentPath);
+        currentPath = pendingPath;
+        if (hotReload) watcher.watch(currentPath);
+    }
+
+    state = LoadState::READY;
+    std::cout << "Model ready: " << pendingPath << " (" << meshTotal.load() << " meshes, "
+              << reused << " reused, " << meshTotal.load() - reused << " uploaded, "
+              << renderer.getMeshCache().getResidentBytes() / 1024 << " KB on GPU)" << std::endl;
+    // Перезагрузки освобождают диапазоны старой сцены - здесь видна фрагментация арен
+    renderer.getMeshCache().printArenaReport();
+    return true;
+}
+
+float AsyncModelLoader::getProgress() const {
+    LoadState current = state.load();
+    if (current == LoadState::READY) return 1.0f;
+    if (current != LoadState::LOADING) return 0.0f;
+
+    size_t total = meshTotal.load();
+    if (total == 0) return 0.0f;
+    // Половина - импорт, половина - загрузка на GPU
+    return 0.5f * (float)(meshesParsed.load() + meshesUploaded.load()) / (float)total;
+}
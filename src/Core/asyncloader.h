@@ -0,0 +1,83 @@
+#ifndef ASYNCLOADER_H
+#define ASYNCLOADER_H
+
+#include <string>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include "parser.h"
+#include "renderer.h"
+#include "boundedqueue.h"
+#include "filewatcher.h"
+
+enum class LoadState {
+    IDLE,
+    LOADING,
+    READY,
+    FAILED
+};
+
+// Фоновая загрузка модели: импорт идёт в рабочих потоках, готовые меши
+// приходят в GL-поток через ограниченную очередь и загружаются на GPU
+// порциями в pump(). До окончания загрузки рисуется предыдущая сцена.
+// При горячей перезагрузке меши с тем же содержимым не загружаются заново:
+// их GPU-handle переходит к новой сцене.
+class AsyncModelLoader {
+public:
+    explicit AsyncModelLoader(size_t queueCapacity = 16);
+    ~AsyncModelLoader();
+
+    bool requestLoad(const std::string& path);
+
+    // Вызывается в GL-потоке раз за кадр. Возвращает true, если сцена переключилась.
+    bool pump(Renderer& renderer, double budgetMs = 4.0);
+
+    std::shared_ptr<ModelParser> getCurrentScene() const { return currentScene; }
+    LoadState getState() const { return state.load(); }
+    bool isLoading() const { return state.load() == LoadState::LOADING; }
+    float getProgress() const;
+    const std::string& getPendingPath() const { return pendingPath; }
+    const std::string& getCurrentPath() const { return currentPath; }
+
+    // Перезагружать текущую модель, когда её файл меняется на диске
+    void setHotReload(bool enabled);
+    bool getHotReload() const { return hotReload; }
+    // true, если последнее переключение сцены было перезагрузкой того же файла
+    bool wasReload() const { return lastSwapWasReload; }
+
+private:
+    void waitForWorker();
+    void pollFileChanges();
+    const StandardMesh* takeResident(const StandardMesh& mesh, const GpuMeshCache& cache);
+
+    std::thread worker;
+    BoundedQueue<const StandardMesh*> uploadQueue;
+
+    std::shared_ptr<ModelParser> currentScene;
+    std::shared_ptr<ModelParser> pendingScene;
+    std::string pendingPath;
+    std::string currentPath;
+
+    FileWatcher watcher;
+    bool hotReload;
+    bool reloadRequested;
+    bool lastSwapWasReload;
+    // Меши текущей сцены по хэшу содержимого и пары (старый, новый) для переноса handle
+    std::unordered_multimap<uint64_t, const StandardMesh*> residentByHash;
+    std::vector<std::pair<const StandardMesh*, const StandardMesh*>> reusedMeshes;
+    // Загрузка на GPU идёт, пока поток импорта ещё пишет профиль сцены, -
+    // её стоимость копится здесь и добавляется после завершения потока
+    ImportProfile uploadProfile;
+
+    std::atomic<LoadState> state;
+    std::atomic<bool> parseFinished;
+    std::atomic<bool> parseSucceeded;
+    std::atomic<size_t> meshTotal;
+    std::atomic<size_t> meshesParsed;
+    std::atomic<size_t> meshesUploaded;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+// Очередь фиксированной ёмкости: производитель ждёт, пока потребитель не освободит место.
+// После close() push больше не блокируется и возвращает false.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(capacity ? capacity : 1), closed(false) {}
+
+    bool push(T value) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return closed || items.size() < capacity; });
+        if (closed) return false;
+        items.push_back(std::move(value));
+        return true;
+    }
+
+    bool tryPop(T& value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (items.empty()) return false;
+        value = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        items.clear();
+        notFull.notify_all();
+    }
+
+    void reopen() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = false;
+        items.clear();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return items.size();
+    }
+
+private:
+    std::deque<T> items;
+    mutable std::mutex mutex;
+    std::condition_variable notFull;
+    size_t capacity;
+    bool closed;
+};
+
+#endif
@@ -0,0 +1,163 @@
+#include "bounds.h"
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BOUNDS_SSE2 1
+#endif
+
+static void setCenter(MeshBounds& bounds) {
+    for (int k = 0; k < 3; k++) bounds.center[k] = (bounds.min[k] + bounds.max[k]) * 0.5f;
+}
+
+#ifdef BOUNDS_SSE2
+
+// Позиция загружается вместе с normal[0] в четвёртой дорожке - её результат отбрасывается
+static void reduceMinMax(const StandardVertex* vertices, size_t count, MeshBounds& bounds) {
+    __m128 lo0 = _mm_loadu_ps(vertices[0].position), hi0 = lo0;
+    __m128 lo1 = lo0, hi1 = lo0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 p0 = _mm_loadu_ps(vertices[i].position);
+        __m128 p1 = _mm_loadu_ps(vertices[i + 1].position);
+        __m128 p2 = _mm_loadu_ps(vertices[i + 2].position);
+        __m128 p3 = _mm_loadu_ps(vertices[i + 3].position);
+        lo0 = _mm_min_ps(lo0, _mm_min_ps(p0, p1));
+        hi0 = _mm_max_ps(hi0, _mm_max_ps(p0, p1));
+        lo1 = _mm_min_ps(lo1, _mm_min_ps(p2, p3));
+        hi1 = _mm_max_ps(hi1, _mm_max_ps(p2, p3));
+    }
+    for (; i < count; i++) {
+        __m128 p = _mm_loadu_ps(vertices[i].position);
+        lo0 = _mm_min_ps(lo0, p);
+        hi0 = _mm_max_ps(hi0, p);
+    }
+
+    float lo[4], hi[4];
+    _mm_storeu_ps(lo, _mm_min_ps(lo0, lo1));
+    _mm_storeu_ps(hi, _mm_max_ps(hi0, hi1));
+    for (int k = 0; k < 3; k++) {
+        bounds.min[k] = lo[k];
+        bounds.max[k] = hi[k];
+    }
+}
+
+// Четыре вершины транспонируются в x/y/z-векторы, квадрат расстояния считается сразу для четырёх
+static float reduceRadiusSquared(const StandardVertex* vertices, size_t count, const float center[3]) {
+    __m128 cx = _mm_set1_ps(center[0]), cy = _mm_set1_ps(center[1]), cz = _mm_set1_ps(center[2]);
+    __m128 best = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 p0 = _mm_loadu_ps(vertices[i].position);
+        __m128 p1 = _mm_loadu_ps(vertices[i + 1].position);
+        __m128 p2 = _mm_loadu_ps(vertices[i + 2].position);
+        __m128 p3 = _mm_loadu_ps(vertices[i + 3].position);
+        _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+        __m128 dx = _mm_sub_ps(p0, cx), dy = _mm_sub_ps(p1, cy), dz = _mm_sub_ps(p2, cz);
+        __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        best = _mm_max_ps(best, d2);
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, best);
+    float result = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+    for (; i < count; i++) {
+        const float* p = vertices[i].position;
+        float dx = p[0] - center[0], dy = p[1] - center[1], dz = p[2] - center[2];
+        result = std::max(result, dx * dx + dy * dy + dz * dz);
+    }
+    return result;
+}
+
+#else
+
+static void reduceMinMax(const StandardVertex* vertices, size_t count, MeshBounds& bounds) {
+    for (int k = 0; k < 3; k++) {
+        bounds.min[k] = vertices[0].position[k];
+        bounds.max[k] = vertices[0].position[k];
+    }
+    for (size_t i = 1; i < count; i++) {
+        const float* p = vertices[i].position;
+        for (int k = 0; k < 3; k++) {
+            bounds.min[k] = std::min(bounds.min[k], p[k]);
+            bounds.max[k] = std::max(bounds.max[k], p[k]);
+        }
+    }
+}
+
+static float reduceRadiusSquared(const StandardVertex* vertices, size_t count, const float center[3]) {
+    float result = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        const float* p = vertices[i].position;
+        float dx = p[0] - center[0], dy = p[1] - center[1], dz = p[2] - center[2];
+        result = std::max(result, dx * dx + dy * dy + dz * dz);
+    }
+    return result;
+}
+
+#endif
+
+void BoundsBuilder::computeMesh(const StandardVertex* vertices, size_t count, MeshBounds& bounds) {
+    if (count == 0) {
+        bounds = MeshBounds();
+        return;
+    }
+    reduceMinMax(vertices, count, bounds);
+    setCenter(bounds);
+    bounds.radius = std::sqrt(reduceRadiusSquared(vertices, count, bounds.center));
+}
+
+MeshBounds BoundsBuilder::transform(const MeshBounds& bounds, const glm::mat4& matrix) {
+    glm::vec3 center = glm::vec3(matrix * glm::vec4(bounds.center[0], bounds.center[1], bounds.center[2], 1.0f));
+    glm::vec3 extent(bounds.max[0] - bounds.center[0], bounds.max[1] - bounds.center[1], bounds.max[2] - bounds.center[2]);
+
+    // Полуразмер нового AABB - сумма модулей столбцов, взвешенных старым полуразмером
+    glm::vec3 worldExtent = glm::abs(glm::vec3(matrix[0])) * extent.x +
+                            glm::abs(glm::vec3(matrix[1])) * extent.y +
+                            glm::abs(glm::vec3(matrix[2])) * extent.z;
+    float scale = std::max(glm::length(glm::vec3(matrix[0])),
+                           std::max(glm::length(glm::vec3(matrix[1])), glm::length(glm::vec3(matrix[2]))));
+
+    MeshBounds result;
+    for (int k = 0; k < 3; k++) {
+        result.min[k] = center[k] - worldExtent[k];
+        result.max[k] = center[k] + worldExtent[k];
+        result.center[k] = center[k];
+    }
+    result.radius = bounds.radius * scale;
+    return result;
+}
+
+bool BoundsBuilder::computeScene(const std::vector<StandardMesh>& meshes, const SceneGraph& sceneGraph, MeshBounds& bounds) {
+    std::vector<MeshBounds> placed;
+    placed.reserve(sceneGraph.getMeshInstances().size());
+    for (const MeshInstance& instance : sceneGraph.getMeshInstances()) {
+        if (instance.mesh >= meshes.size() || meshes[instance.mesh].baseIndexCount() == 0) continue;
+        placed.push_back(transform(meshes[instance.mesh].bounds, sceneGraph.getWorldTransform(instance.node)));
+    }
+    if (placed.empty()) {
+        bounds = MeshBounds();
+        return false;
+    }
+
+    bounds = placed[0];
+    for (const MeshBounds& b : placed) {
+        for (int k = 0; k < 3; k++) {
+            bounds.min[k] = std::min(bounds.min[k], b.min[k]);
+            bounds.max[k] = std::max(bounds.max[k], b.max[k]);
+        }
+    }
+    setCenter(bounds);
+
+    // Сфера сцены вокруг центра AABB охватывает сферы всех экземпляров
+    glm::vec3 center(bounds.center[0], bounds.center[1], bounds.center[2]);
+    float radius = 0.0f;
+    for (const MeshBounds& b : placed) {
+        radius = std::max(radius, glm::length(glm::vec3(b.center[0], b.center[1], b.center[2]) - center) + b.radius);
+    }
+    // Половина диагонали AABB сцены тоже охватывает всё - берём меньшую из двух
+    float halfDiagonal = glm::length(glm::vec3(bounds.max[0], bounds.max[1], bounds.max[2]) - center);
+    bounds.radius = std::min(radius, halfDiagonal);
+    return true;
+}
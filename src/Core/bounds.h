@@ -0,0 +1,22 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <vector>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include "parser.h"
+
+// Границы мешей и сцены. Меш сканируется один раз при импорте (SSE, если есть),
+// дальше отсечение и камера берут готовые AABB и сферу из StandardMesh::bounds
+class BoundsBuilder {
+public:
+    static void computeMesh(const StandardVertex* vertices, size_t count, MeshBounds& bounds);
+
+    // Объединение границ всех экземпляров с их мировыми матрицами; false - в сцене нет геометрии
+    static bool computeScene(const std::vector<StandardMesh>& meshes, const SceneGraph& sceneGraph, MeshBounds& bounds);
+
+    // Границы после аффинного преобразования: AABB по модулю матрицы, сфера по наибольшему масштабу
+    static MeshBounds transform(const MeshBounds& bounds, const glm::mat4& matrix);
+};
+
+#endif
@@ -4,6 +4,8 @@
 #include "interfaces.h"
 #include "renderer.h"
 #include "parser.h"
+#include "asyncloader.h"
+#include "animator.h"
 #include <memory>
 #include <vector>
 
@@ -118,7 +120,7 @@ private:
 class RenderingCore : public Core, public IRenderable {
 public:
     RenderingCore(std::shared_ptr<ApplicationCore> appCore) 
-        : appCore(appCore), shaderProgram(0) {}
+        : appCore(appCore) {}
     
     bool initialize() override {
         if (!appCore->getWindow()) {
@@ -133,17 +135,9 @@ public:
             return false;
         }
         
-        // Компиляция шейдеров
-        shaderProgram = initShaders();
-        if (shaderProgram == 0) {
-            std::cout << "Failed to compile shaders!" << std::endl;
-            return false;
-        }
-        
-        // Загрузка модели (можно вынести в конфигурацию)
-        if (!modelParser.loadModel("resources/models/model.obj")) {
-            std::cout << "Failed to load model! Using default..." << std::endl;
-        }
+        // Загрузка модели в фоне (можно вынести в конфигурацию)
+        modelLoader.setHotReload(true);
+        modelLoader.requestLoad("resources/models/model.obj");
         
         glEnable(GL_DEPTH_TEST);
         glEnable(GL_CULL_FACE);
@@ -157,9 +151,6 @@ public:
     }
     
     void cleanup() override {
-        if (shaderProgram != 0) {
-            glDeleteProgram(shaderProgram);
-        }
         renderer->cleanup();
     }
     
@@ -167,8 +158,22 @@ public:
     void render(float deltaTime) override {
         beginFrame();
         
+        // Догружаем готовые меши на GPU, пока рисуется предыдущая сцена
+        if (modelLoader.pump(*renderer)) {
+            animator.reset();
+        }
+        
         // Рендеринг модели
-        renderer->renderModel(modelParser, shaderProgram);
+        std::shared_ptr<ModelParser> scene = modelLoader.getCurrentScene();
+        if (scene) {
+            if (scene->isAnimated()) {
+                animator.update(*scene, deltaTime);
+                animator.upload(renderer->getMeshCache(), *scene);
+            } else {
+                scene->getSceneGraph().updateWorldTransforms();
+            }
+            renderer->renderModel(*scene);
+        }
         
         // Рендеринг интерфейса поверх всего
         renderUI();
@@ -190,13 +195,15 @@ public:
     }
     
     Renderer* getRenderer() const { return renderer.get(); }
-    ModelParser* getModelParser() { return &modelParser; }
+    ModelParser* getModelParser() { return modelLoader.getCurrentScene().get(); }
+    AsyncModelLoader& getModelLoader() { return modelLoader; }
+    Animator& getAnimator() { return animator; }
     
 private:
     std::shared_ptr<ApplicationCore> appCore;
     std::unique_ptr<Renderer> renderer;
-    ModelParser modelParser;
-    GLuint shaderProgram;
+    AsyncModelLoader modelLoader;
+    Animator animator;
 };
 
 // ============================================================================
@@ -0,0 +1,151 @@
+#include "filewatcher.h"
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+static long long getModifiedTime(const std::string& path) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) return -1;
+    return (long long)info.st_mtime;
+}
+
+static std::string getDirectory(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+}
+
+// Ключ вида "каталог/имя" - в таком виде имена приходят из inotify
+static std::string getWatchKey(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    return getDirectory(path) + "/" + (slash == std::string::npos ? path : path.substr(slash + 1));
+}
+
+bool FileWatcher::isWatching(const std::string& path) const {
+    return files.count(getWatchKey(path)) != 0;
+}
+
+void FileWatcher::markChanged(WatchedFile& file) {
+    file.changed = true;
+    file.lastEvent = Clock::now();
+}
+
+std::vector<std::string> FileWatcher::collectSettled(Clock::time_point now) {
+    std::vector<std::string> changed;
+    for (auto& entry : files) {
+        if (entry.second.changed && now - entry.second.lastEvent >= debounce) {
+            entry.second.changed = false;
+            changed.push_back(entry.second.path);
+        }
+    }
+    return changed;
+}
+
+#ifdef _WIN32
+
+FileWatcher::FileWatcher(int debounceMs) : debounce(debounceMs), lastScan(Clock::now()) {}
+
+FileWatcher::~FileWatcher() {}
+
+bool FileWatcher::watch(const std::string& path) {
+    if (isWatching(path)) return true;
+
+    WatchedFile file = {path, -1, getModifiedTime(path), false, Clock::now()};
+    if (file.modifiedTime < 0) return false;
+    files[getWatchKey(path)] = file;
+    return true;
+}
+
+void FileWatcher::unwatch(const std::string& path) {
+    files.erase(getWatchKey(path));
+}
+
+std::vector<std::string> FileWatcher::poll() {
+    Clock::time_point now = Clock::now();
+
+    // stat на каждый кадр не нужен - достаточно пары раз в секунду
+    if (now - lastScan >= std::chrono::milliseconds(500)) {
+        lastScan = now;
+        for (auto& entry : files) {
+            long long modified = getModifiedTime(entry.second.path);
+            if (modified >= 0 && modified != entry.second.modifiedTime) {
+                entry.second.modifiedTime = modified;
+                markChanged(entry.second);
+            }
+        }
+    }
+
+    return collectSettled(now);
+}
+
+#else
+
+FileWatcher::FileWatcher(int debounceMs)
+    : debounce(debounceMs), lastScan(Clock::now()),
+      inotifyDescriptor(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {}
+
+FileWatcher::~FileWatcher() {
+    if (inotifyDescriptor >= 0) {
+        ::close(inotifyDescriptor);
+    }
+}
+
+bool FileWatcher::watch(const std::string& path) {
+    if (isWatching(path)) return true;
+    if (inotifyDescriptor < 0) return false;
+
+    // Следим за каталогом: многие редакторы пишут во временный файл и переименовывают его
+    std::string directory = getDirectory(path);
+    int wd = inotify_add_watch(inotifyDescriptor, directory.c_str(),
+                               IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY);
+    if (wd < 0) return false;
+
+    directories[wd] = directory;
+    WatchedFile file = {path, wd, getModifiedTime(path), false, Clock::now()};
+    files[getWatchKey(path)] = file;
+    return true;
+}
+
+void FileWatcher::unwatch(const std::string& path) {
+    auto it = files.find(getWatchKey(path));
+    if (it == files.end()) return;
+
+    int wd = it->second.watchDescriptor;
+    files.erase(it);
+
+    for (const auto& entry : files) {
+        if (entry.second.watchDescriptor == wd) return;
+    }
+    inotify_rm_watch(inotifyDescriptor, wd);
+    directories.erase(wd);
+}
+
+std::vector<std::string> FileWatcher::poll() {
+    alignas(inotify_event) char buffer[4096];
+
+    while (inotifyDescriptor >= 0) {
+        ssize_t length = read(inotifyDescriptor, buffer, sizeof(buffer));
+        if (length <= 0) break;
+
+        for (ssize_t offset = 0; offset < length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+            if (event->len == 0) continue;
+
+            auto directory = directories.find(event->wd);
+            if (directory == directories.end()) continue;
+
+            auto file = files.find(directory->second + "/" + event->name);
+            if (file != files.end()) {
+                markChanged(file->second);
+            }
+        }
+    }
+
+    Clock::time_point now = Clock::now();
+    return collectSettled(now);
+}
+
+#endif
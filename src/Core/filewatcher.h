@@ -0,0 +1,51 @@
+#ifndef FILEWATCHER_H
+#define FILEWATCHER_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+
+// Отслеживание изменений файлов без блокировки: inotify на Linux,
+// на остальных платформах - опрос времени изменения.
+// Изменение сообщается, когда файл не трогали debounceMs миллисекунд:
+// редакторы и экспортёры пишут файл в несколько приёмов.
+class FileWatcher {
+public:
+    explicit FileWatcher(int debounceMs = 200);
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    bool watch(const std::string& path);
+    void unwatch(const std::string& path);
+    bool isWatching(const std::string& path) const;
+
+    // Вызывается раз за кадр, возвращает файлы, изменение которых завершилось
+    std::vector<std::string> poll();
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct WatchedFile {
+        std::string path;
+        int watchDescriptor;
+        long long modifiedTime;
+        bool changed;
+        Clock::time_point lastEvent;
+    };
+
+    void markChanged(WatchedFile& file);
+    std::vector<std::string> collectSettled(Clock::time_point now);
+
+    std::unordered_map<std::string, WatchedFile> files;
+    std::chrono::milliseconds debounce;
+    Clock::time_point lastScan;
+#ifndef _WIN32
+    int inotifyDescriptor;
+    std::unordered_map<int, std::string> directories; // дескриптор inotify -> каталог
+#endif
+};
+
+#endif
@@ -0,0 +1,30 @@
+#include "frustum.h"
+
+Frustum Frustum::fromMatrix(const glm::mat4& clip) {
+    Frustum frustum;
+    glm::vec4 row0(clip[0][0], clip[1][0], clip[2][0], clip[3][0]);
+    glm::vec4 row1(clip[0][1], clip[1][1], clip[2][1], clip[3][1]);
+    glm::vec4 row2(clip[0][2], clip[1][2], clip[2][2], clip[3][2]);
+    glm::vec4 row3(clip[0][3], clip[1][3], clip[2][3], clip[3][3]);
+
+    frustum.planes[0] = row3 + row0;
+    frustum.planes[1] = row3 - row0;
+    frustum.planes[2] = row3 + row1;
+    frustum.planes[3] = row3 - row1;
+    frustum.planes[4] = row3 + row2;
+    frustum.planes[5] = row3 - row2;
+
+    for (auto& plane : frustum.planes) {
+        float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f) plane /= length;
+    }
+    return frustum;
+}
+
+bool Frustum::intersectsSphere(const float center[3], float radius) const {
+    for (const auto& plane : planes) {
+        float distance = plane.x * center[0] + plane.y * center[1] + plane.z * center[2] + plane.w;
+        if (distance < -radius) return false;
+    }
+    return true;
+}
@@ -0,0 +1,15 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// Плоскости отсечения (Gribb/Hartmann). Построенные из projection * view * model,
+// они позволяют проверять объекты прямо в пространстве модели.
+struct Frustum {
+    glm::vec4 planes[6];
+
+    static Frustum fromMatrix(const glm::mat4& clip);
+    bool intersectsSphere(const float center[3], float radius) const;
+};
+
+#endif
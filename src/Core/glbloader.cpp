@@ -0,0 +1,515 @@
+#include "glbloader.h"
+#include "mappedfile.h"
+#include "threadpool.h"
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <atomic>
+#include <algorithm>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+static const uint32_t GLB_MAGIC = 0x46546C67;      // "glTF"
+static const uint32_t GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+static const uint32_t GLB_CHUNK_BIN = 0x004E4942;  // "BIN\0"
+
+static const int GLTF_BYTE = 5120;
+static const int GLTF_UNSIGNED_BYTE = 5121;
+static const int GLTF_SHORT = 5122;
+static const int GLTF_UNSIGNED_SHORT = 5123;
+static const int GLTF_UNSIGNED_INT = 5125;
+static const int GLTF_FLOAT = 5126;
+static const int GLTF_TRIANGLES = 4;
+
+static const int MAX_JSON_DEPTH = 64;
+
+// Минимальное дерево JSON - ровно столько, сколько нужно для заголовка glTF
+struct JsonValue {
+    enum Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+    Type type = NUL;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> items;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    const JsonValue& operator[](const char* key) const {
+        for (const auto& member : members) {
+            if (member.first == key) return member.second;
+        }
+        return null();
+    }
+
+    const JsonValue& operator[](size_t index) const {
+        return index < items.size() ? items[index] : null();
+    }
+
+    const JsonValue& operator[](int index) const { return (*this)[(size_t)index]; }
+
+    bool has(const char* key) const { return &(*this)[key] != &null(); }
+    size_t size() const { return type == ARRAY ? items.size() : members.size(); }
+    double toNumber(double fallback) const { return type == NUMBER ? number : fallback; }
+    long long toIndex() const { return type == NUMBER && number >= 0.0 ? (long long)number : -1; }
+
+    static const JsonValue& null() {
+        static const JsonValue value;
+        return value;
+    }
+};
+
+class JsonReader {
+public:
+    JsonReader(const char* begin, const char* end) : p(begin), end(end) {}
+
+    bool parse(JsonValue& value) {
+        if (!parseValue(value, 0)) return false;
+        skipSpaces();
+        return p == end;
+    }
+
+private:
+    const char* p;
+    const char* end;
+
+    void skipSpaces() {
+        // Чанк JSON в GLB дополняется пробелами до кратности 4
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r' || *p == '\0')) p++;
+    }
+
+    bool expect(const char* literal) {
+        size_t length = std::strlen(literal);
+        if ((size_t)(end - p) < length || std::memcmp(p, literal, length) != 0) return false;
+        p += length;
+        return true;
+    }
+
+    bool parseValue(JsonValue& value, int depth) {
+        if (depth > MAX_JSON_DEPTH) return false;
+        skipSpaces();
+        if (p >= end) return false;
+
+        switch (*p) {
+            case '{': return parseObject(value, depth);
+            case '[': return parseArray(value, depth);
+            case '"': value.type = JsonValue::STRING; return parseString(value.string);
+            case 't': value.type = JsonValue::BOOLEAN; value.boolean = true; return expect("true");
+            case 'f': value.type = JsonValue::BOOLEAN; value.boolean = false; return expect("false");
+            case 'n': value.type = JsonValue::NUL; return expect("null");
+            default: return parseNumber(value);
+        }
+    }
+
+    bool parseNumber(JsonValue& value) {
+        // strtod нужен ноль в конце, поэтому число копируется в буфер
+        char buffer[64];
+        size_t length = 0;
+        while (p + length < end && length < sizeof(buffer) - 1 && std::strchr("+-0123456789.eE", p[length])) length++;
+        if (length == 0) return false;
+        std::memcpy(buffer, p, length);
+        buffer[length] = '\0';
+
+        char* parsedEnd = nullptr;
+        value.type = JsonValue::NUMBER;
+        value.number = std::strtod(buffer, &parsedEnd);
+        if (parsedEnd != buffer + length) return false;
+        p += length;
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, unsigned int code) {
+        if (code < 0x80) {
+            out += (char)code;
+        } else if (code < 0x800) {
+            out += (char)(0xC0 | (code >> 6));
+            out += (char)(0x80 | (code & 0x3F));
+        } else {
+            out += (char)(0xE0 | (code >> 12));
+            out += (char)(0x80 | ((code >> 6) & 0x3F));
+            out += (char)(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool parseString(std::string& out) {
+        p++;
+        while (p < end && *p != '"') {
+            if (*p != '\\') {
+                out += *p++;
+                continue;
+            }
+            if (++p >= end) return false;
+            switch (*p++) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    if (end - p < 4) return false;
+                    char hex[5] = {p[0], p[1], p[2], p[3], '\0'};
+                    char* hexEnd = nullptr;
+                    unsigned long code = std::strtoul(hex, &hexEnd, 16);
+                    if (hexEnd != hex + 4) return false;
+                    // Суррогатные пары в именах узлов не восстанавливаем
+                    appendUtf8(out, code >= 0xD800 && code <= 0xDFFF ? '?' : (unsigned int)code);
+                    p += 4;
+                    break;
+                }
+                default: return false;
+            }
+        }
+        if (p >= end) return false;
+        p++;
+        return true;
+    }
+
+    bool parseArray(JsonValue& value, int depth) {
+        value.type = JsonValue::ARRAY;
+        p++;
+        skipSpaces();
+        if (p < end && *p == ']') {
+            p++;
+            return true;
+        }
+        while (true) {
+            value.items.push_back(JsonValue());
+            if (!parseValue(value.items.back(), depth + 1)) return false;
+            skipSpaces();
+            if (p >= end) return false;
+            if (*p == ']') {
+                p++;
+                return true;
+            }
+            if (*p++ != ',') return false;
+        }
+    }
+
+    bool parseObject(JsonValue& value, int depth) {
+        value.type = JsonValue::OBJECT;
+        p++;
+        skipSpaces();
+        if (p < end && *p == '}') {
+            p++;
+            return true;
+        }
+        while (true) {
+            skipSpaces();
+            if (p >= end || *p != '"') return false;
+            value.members.push_back(std::make_pair(std::string(), JsonValue()));
+            if (!parseString(value.members.back().first)) return false;
+            skipSpaces();
+            if (p >= end || *p++ != ':') return false;
+            if (!parseValue(value.members.back().second, depth + 1)) return false;
+            skipSpaces();
+            if (p >= end) return false;
+            if (*p == '}') {
+                p++;
+                return true;
+            }
+            if (*p++ != ',') return false;
+        }
+    }
+};
+
+// Аксессор, разрешённый до указателя в BIN-чанке
+struct AccessorView {
+    const unsigned char* data;
+    size_t count;
+    size_t stride;
+    int componentType;
+    int components;
+    bool normalized;
+};
+
+static size_t componentSize(int componentType) {
+    switch (componentType) {
+        case GLTF_BYTE:
+        case GLTF_UNSIGNED_BYTE: return 1;
+        case GLTF_SHORT:
+        case GLTF_UNSIGNED_SHORT: return 2;
+        case GLTF_UNSIGNED_INT:
+        case GLTF_FLOAT: return 4;
+        default: return 0;
+    }
+}
+
+static int componentCount(const std::string& type) {
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4") return 4;
+    return 0;
+}
+
+static bool resolveAccessor(const JsonValue& gltf, const unsigned char* bin, size_t binSize,
+                            long long index, AccessorView& view) {
+    const JsonValue& accessor = gltf["accessors"][(size_t)index];
+    if (index < 0 || accessor.type != JsonValue::OBJECT || accessor.has("sparse")) return false;
+
+    const JsonValue& bufferView = gltf["bufferViews"][(size_t)accessor["bufferView"].toIndex()];
+    if (bufferView.type != JsonValue::OBJECT || bufferView["buffer"].toIndex() != 0) return false;
+
+    view.componentType = (int)accessor["componentType"].toNumber(0);
+    view.components = componentCount(accessor["type"].string);
+    view.normalized = accessor["normalized"].boolean;
+    view.count = (size_t)accessor["count"].toNumber(0);
+
+    size_t elementSize = componentSize(view.componentType) * view.components;
+    if (elementSize == 0) return false;
+
+    size_t viewOffset = (size_t)bufferView["byteOffset"].toNumber(0);
+    size_t viewLength = (size_t)bufferView["byteLength"].toNumber(0);
+    size_t accessorOffset = (size_t)accessor["byteOffset"].toNumber(0);
+    view.stride = (size_t)bufferView["byteStride"].toNumber((double)elementSize);
+    if (view.stride < elementSize || viewOffset + viewLength > binSize) return false;
+
+    size_t required = view.count ? accessorOffset + view.stride * (view.count - 1) + elementSize : 0;
+    if (required > viewLength) return false;
+
+    view.data = bin + viewOffset + accessorOffset;
+    return true;
+}
+
+static float readComponent(const unsigned char* p, int componentType, bool normalized) {
+    switch (componentType) {
+        case GLTF_FLOAT: { float v; std::memcpy(&v, p, 4); return v; }
+        case GLTF_UNSIGNED_BYTE: return normalized ? *p / 255.0f : (float)*p;
+        case GLTF_BYTE: { float v = (float)(int8_t)*p; return normalized ? std::max(v / 127.0f, -1.0f) : v; }
+        case GLTF_UNSIGNED_SHORT: { uint16_t v; std::memcpy(&v, p, 2); return normalized ? v / 65535.0f : (float)v; }
+        case GLTF_SHORT: { int16_t v; std::memcpy(&v, p, 2); return normalized ? std::max(v / 32767.0f, -1.0f) : (float)v; }
+        case GLTF_UNSIGNED_INT: { uint32_t v; std::memcpy(&v, p, 4); return (float)v; }
+        default: return 0.0f;
+    }
+}
+
+static void readAttribute(const AccessorView& view, size_t attributeOffset, int components, std::vector<StandardVertex>& vertices) {
+    size_t size = componentSize(view.componentType);
+    for (size_t i = 0; i < view.count; i++) {
+        float* out = reinterpret_cast<float*>(reinterpret_cast<unsigned char*>(&vertices[i]) + attributeOffset);
+        const unsigned char* element = view.data + i * view.stride;
+        for (int k = 0; k < components; k++) {
+            out[k] = readComponent(element + k * size, view.componentType, view.normalized);
+        }
+    }
+}
+
+// Позиция, нормаль и UV из одного bufferView в точности как StandardVertex
+static bool matchesStandardLayout(const AccessorView& position, const AccessorView& normal, const AccessorView& uv) {
+    const size_t stride = sizeof(StandardVertex);
+    return position.componentType == GLTF_FLOAT && normal.componentType == GLTF_FLOAT && uv.componentType == GLTF_FLOAT &&
+           position.stride == stride && normal.stride == stride && uv.stride == stride &&
+           normal.count == position.count && uv.count == position.count &&
+           normal.data == position.data + offsetof(StandardVertex, normal) &&
+           uv.data == position.data + offsetof(StandardVertex, texCoords) &&
+           reinterpret_cast<uintptr_t>(position.data) % alignof(StandardVertex) == 0;
+}
+
+struct PrimitiveRef {
+    size_t mesh;
+    size_t primitive;
+};
+
+static bool loadPrimitive(const JsonValue& gltf, const unsigned char* bin, size_t binSize,
+                          const PrimitiveRef& ref, StandardMesh& mesh, bool& zeroCopy) {
+    const JsonValue& primitive = gltf["meshes"][ref.mesh]["primitives"][ref.primitive];
+    const JsonValue& attributes = primitive["attributes"];
+    if ((int)primitive["mode"].toNumber(GLTF_TRIANGLES) != GLTF_TRIANGLES) return false;
+
+    // Без нормалей - через Assimp: их сгладит TangentSpace в общем конвейере
+    AccessorView position, normal, uv;
+    if (!resolveAccessor(gltf, bin, binSize, attributes["POSITION"].toIndex(), position) || position.components != 3) return false;
+    if (!resolveAccessor(gltf, bin, binSize, attributes["NORMAL"].toIndex(), normal) || normal.components != 3 ||
+        normal.count != position.count) return false;
+    bool hasUv = attributes.has("TEXCOORD_0");
+    if (hasUv && (!resolveAccessor(gltf, bin, binSize, attributes["TEXCOORD_0"].toIndex(), uv) || uv.components != 2 ||
+                  uv.count != position.count)) return false;
+
+    // UV glTF уже в той системе, что получается у Assimp после FlipUVs (он сам их переворачивает при импорте)
+    zeroCopy = hasUv && matchesStandardLayout(position, normal, uv);
+    if (zeroCopy) {
+        mesh.mappedVertices = reinterpret_cast<const StandardVertex*>(position.data);
+        mesh.mappedVertexCount = position.count;
+    } else {
+        mesh.vertices.assign(position.count, StandardVertex());
+        readAttribute(position, offsetof(StandardVertex, position), 3, mesh.vertices);
+        readAttribute(normal, offsetof(StandardVertex, normal), 3, mesh.vertices);
+        if (hasUv) readAttribute(uv, offsetof(StandardVertex, texCoords), 2, mesh.vertices);
+    }
+
+    // Индексы всегда свои: к ним дописываются LOD и их переупорядочивает оптимизатор
+    if (primitive.has("indices")) {
+        AccessorView indices;
+        if (!resolveAccessor(gltf, bin, binSize, primitive["indices"].toIndex(), indices) || indices.components != 1) return false;
+
+        mesh.indices.resize(indices.count);
+        if (indices.componentType == GLTF_UNSIGNED_INT && indices.stride == sizeof(uint32_t)) {
+            std::memcpy(mesh.indices.data(), indices.data, indices.count * sizeof(uint32_t));
+        } else if (indices.componentType == GLTF_UNSIGNED_SHORT) {
+            for (size_t i = 0; i < indices.count; i++) {
+                uint16_t index;
+                std::memcpy(&index, indices.data + i * indices.stride, sizeof(index));
+                mesh.indices[i] = index;
+            }
+        } else if (indices.componentType == GLTF_UNSIGNED_BYTE) {
+            for (size_t i = 0; i < indices.count; i++) mesh.indices[i] = indices.data[i * indices.stride];
+        } else {
+            return false;
+        }
+    } else {
+        mesh.indices.resize(position.count);
+        for (size_t i = 0; i < position.count; i++) mesh.indices[i] = (unsigned int)i;
+    }
+
+    if (mesh.indices.size() % 3 != 0) return false;
+    for (unsigned int index : mesh.indices) {
+        if (index >= position.count) return false;
+    }
+    return true;
+}
+
+static glm::mat4 nodeTransform(const JsonValue& node) {
+    const JsonValue& matrix = node["matrix"];
+    if (matrix.size() == 16) {
+        // glTF хранит матрицу по столбцам, как и glm
+        glm::mat4 result;
+        for (int c = 0; c < 4; c++) {
+            for (int r = 0; r < 4; r++) result[c][r] = (float)matrix[(size_t)(c * 4 + r)].toNumber(0.0);
+        }
+        return result;
+    }
+
+    const JsonValue& t = node["translation"];
+    const JsonValue& r = node["rotation"];
+    const JsonValue& s = node["scale"];
+    glm::vec3 translation((float)t[0].toNumber(0.0), (float)t[1].toNumber(0.0), (float)t[2].toNumber(0.0));
+    glm::quat rotation((float)r[3].toNumber(1.0), (float)r[0].toNumber(0.0), (float)r[1].toNumber(0.0), (float)r[2].toNumber(0.0));
+    glm::vec3 scale((float)s[0].toNumber(1.0), (float)s[1].toNumber(1.0), (float)s[2].toNumber(1.0));
+    return glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), scale);
+}
+
+// Обход в глубину: узлы добавляются в SceneGraph в нужном ему порядке,
+// примитивы каждого меша glTF получают слоты при первой встрече
+static bool addNode(const JsonValue& gltf, long long index, int parent, SceneGraph& sceneGraph,
+                    std::vector<char>& visited, std::vector<std::vector<uint32_t>>& meshSlots,
+                    std::vector<PrimitiveRef>& primitives) {
+    const JsonValue& node = gltf["nodes"][(size_t)index];
+    if (index < 0 || node.type != JsonValue::OBJECT || visited[(size_t)index]) return false;
+    visited[(size_t)index] = 1;
+
+    uint32_t nodeIndex = sceneGraph.addNode(parent, nodeTransform(node), node["name"].string);
+
+    if (node.has("mesh")) {
+        long long mesh = node["mesh"].toIndex();
+        if (mesh < 0 || (size_t)mesh >= meshSlots.size()) return false;
+
+        std::vector<uint32_t>& slots = meshSlots[(size_t)mesh];
+        if (slots.empty()) {
+            size_t primitiveCount = gltf["meshes"][(size_t)mesh]["primitives"].size();
+            for (size_t p = 0; p < primitiveCount; p++) {
+                slots.push_back((uint32_t)primitives.size());
+                primitives.push_back(PrimitiveRef{(size_t)mesh, p});
+            }
+        }
+        for (uint32_t slot : slots) sceneGraph.addMeshInstance(nodeIndex, slot);
+    }
+
+    const JsonValue& children = node["children"];
+    for (size_t i = 0; i < children.size(); i++) {
+        if (!addNode(gltf, children[i].toIndex(), (int)nodeIndex, sceneGraph, visited, meshSlots, primitives)) return false;
+    }
+    return true;
+}
+
+bool GlbLoader::isGlbFile(const std::string& path) {
+    if (path.size() < 4) return false;
+    std::string extension = path.substr(path.size() - 4);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == ".glb";
+}
+
+bool GlbLoader::load(const std::string& path, std::vector<StandardMesh>& meshes, SceneGraph& sceneGraph,
+                     std::shared_ptr<MappedFile>& mapping, size_t& zeroCopyMeshes) {
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+    if (!file->open(path) || file->size() < 20) return false;
+
+    const unsigned char* data = file->data();
+    uint32_t header[3];
+    std::memcpy(header, data, sizeof(header));
+    if (header[0] != GLB_MAGIC || header[1] != 2 || header[2] > file->size()) return false;
+
+    // Первый чанк - JSON, второй (необязательный) - BIN
+    uint32_t jsonChunk[2];
+    std::memcpy(jsonChunk, data + 12, sizeof(jsonChunk));
+    if (jsonChunk[1] != GLB_CHUNK_JSON || 20 + (size_t)jsonChunk[0] > header[2]) return false;
+    const char* json = reinterpret_cast<const char*>(data + 20);
+
+    const unsigned char* bin = nullptr;
+    size_t binSize = 0;
+    size_t binHeader = 20 + (size_t)jsonChunk[0];
+    if (binHeader + 8 <= header[2]) {
+        uint32_t binChunk[2];
+        std::memcpy(binChunk, data + binHeader, sizeof(binChunk));
+        if (binChunk[1] == GLB_CHUNK_BIN && binHeader + 8 + binChunk[0] <= header[2]) {
+            bin = data + binHeader + 8;
+            binSize = binChunk[0];
+        }
+    }
+
+    JsonValue gltf;
+    if (!JsonReader(json, json + jsonChunk[0]).parse(gltf) || gltf.type != JsonValue::OBJECT) return false;
+    // Скины и анимация импортируются только через Assimp
+    if (gltf["extensionsRequired"].size() > 0 || gltf["skins"].size() > 0 || gltf["animations"].size() > 0) return false;
+    // Единственный буфер - BIN-чанк; внешние файлы и data URI оставляем Assimp
+    const JsonValue& buffers = gltf["buffers"];
+    if (buffers.size() > 1 || (buffers.size() == 1 && (buffers[0].has("uri") || !bin))) return false;
+
+    size_t nodeCount = gltf["nodes"].size();
+    std::vector<char> visited(nodeCount, 0);
+    std::vector<std::vector<uint32_t>> meshSlots(gltf["meshes"].size());
+    std::vector<PrimitiveRef> primitives;
+
+    // Корни - узлы сцены по умолчанию, а без сцен - все узлы без родителя
+    std::vector<long long> roots;
+    const JsonValue& scene = gltf["scenes"][(size_t)std::max(0LL, gltf["scene"].toIndex())];
+    if (scene.type == JsonValue::OBJECT) {
+        for (size_t i = 0; i < scene["nodes"].size(); i++) roots.push_back(scene["nodes"][i].toIndex());
+    } else {
+        std::vector<char> isChild(nodeCount, 0);
+        for (size_t i = 0; i < nodeCount; i++) {
+            const JsonValue& children = gltf["nodes"][i]["children"];
+            for (size_t c = 0; c < children.size(); c++) {
+                long long child = children[c].toIndex();
+                if (child >= 0 && (size_t)child < nodeCount) isChild[(size_t)child] = 1;
+            }
+        }
+        for (size_t i = 0; i < nodeCount; i++) {
+            if (!isChild[i]) roots.push_back((long long)i);
+        }
+    }
+
+    SceneGraph graph;
+    for (long long root : roots) {
+        if (!addNode(gltf, root, SCENE_NO_PARENT, graph, visited, meshSlots, primitives)) return false;
+    }
+    if (primitives.empty()) return false;
+
+    std::vector<StandardMesh> loaded(primitives.size());
+    std::vector<char> zeroCopy(primitives.size(), 0);
+    std::atomic<bool> failed(false);
+    ThreadPool::shared().parallelFor(primitives.size(), [&](size_t i) {
+        bool mapped = false;
+        if (!loadPrimitive(gltf, bin, binSize, primitives[i], loaded[i], mapped)) failed = true;
+        zeroCopy[i] = mapped;
+    });
+    if (failed) return false;
+
+    graph.sortInstancesByMesh();
+    meshes.swap(loaded);
+    sceneGraph = std::move(graph);
+    mapping = file;
+    zeroCopyMeshes = (size_t)std::count(zeroCopy.begin(), zeroCopy.end(), 1);
+    return true;
+}
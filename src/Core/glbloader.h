@@ -0,0 +1,28 @@
+#ifndef GLBLOADER_H
+#define GLBLOADER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include "parser.h"
+
+class MappedFile;
+
+// Собственный загрузчик glTF 2.0 в контейнере GLB. Файл отображается в память;
+// если вершины примитива лежат в bufferView ровно в раскладке StandardVertex
+// (float3 позиция, float3 нормаль, float2 UV с шагом 32 байта), меш ссылается
+// прямо на эти байты, и они уходят в glBufferData без перепаковки. Остальные
+// раскладки читаются по аксессорам в обычный массив вершин.
+// Каждый примитив - отдельный меш, как у Assimp; узлы переносятся в SceneGraph.
+class GlbLoader {
+public:
+    static bool isGlbFile(const std::string& path);
+
+    // false - в файле то, что умеет только Assimp (внешние буферы, sparse-аксессоры,
+    // обязательные расширения, скины и анимация, не треугольники, нет нормалей), или он повреждён.
+    // mapping держит файл, пока на него ссылаются меши; zeroCopyMeshes - сколько их таких
+    static bool load(const std::string& path, std::vector<StandardMesh>& meshes, SceneGraph& sceneGraph,
+                     std::shared_ptr<MappedFile>& mapping, size_t& zeroCopyMeshes);
+};
+
+#endif
@@ -0,0 +1,347 @@
+#include "gpumesh.h"
+#include <cstddef>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+// Начальная ёмкость арен; дальше ёмкость удваивается
+const size_t MIN_ARENA_VERTICES = 65536;
+const size_t MIN_ARENA_INDEX_BYTES = 1 << 20;
+
+GpuMeshCache::GpuMeshCache()
+    : nextHandle(1), residentBytes(0), vertexFormat(VertexFormat::COMPACT_SNORM16), indexBuffer(0) {
+    for (VertexArena& arena : arenas) {
+        arena.VAO = 0;
+        arena.VBO = 0;
+        arena.tangentVBO = 0;
+    }
+}
+
+void setupVertexAttributes(VertexFormat format) {
+    if (format == VertexFormat::FLOAT32) {
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(StandardVertex), (void*)offsetof(StandardVertex, position));
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(StandardVertex), (void*)offsetof(StandardVertex, normal));
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(StandardVertex), (void*)offsetof(StandardVertex, texCoords));
+    } else {
+        if (format == VertexFormat::COMPACT_HALF) {
+            glVertexAttribPointer(0, 3, GL_HALF_FLOAT, GL_FALSE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, position));
+        } else {
+            glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, position));
+        }
+        // Октаэдрическая нормаль приходит как vec2, шейдер распаковывает её при octNormals
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, normal));
+        glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, texCoords));
+    }
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+}
+
+void bindInstanceTransforms(GLuint buffer, size_t offset) {
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (GLuint column = 0; column < 4; column++) {
+        GLuint location = INSTANCE_MATRIX_LOCATION + column;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceTransform),
+                              (void*)(offset + offsetof(InstanceTransform, world) + column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(location, 1);
+        glEnableVertexAttribArray(location);
+    }
+    for (GLuint column = 0; column < 3; column++) {
+        GLuint location = INSTANCE_NORMAL_LOCATION + column;
+        glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceTransform),
+                              (void*)(offset + offsetof(InstanceTransform, normal) + column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(location, 1);
+        glEnableVertexAttribArray(location);
+    }
+}
+
+void unbindInstanceTransforms() {
+    for (GLuint column = 0; column < 4; column++) {
+        glDisableVertexAttribArray(INSTANCE_MATRIX_LOCATION + column);
+    }
+    for (GLuint column = 0; column < 3; column++) {
+        glDisableVertexAttribArray(INSTANCE_NORMAL_LOCATION + column);
+    }
+}
+
+void setConstantInstanceTransform(const InstanceTransform& transform) {
+    for (GLuint column = 0; column < 4; column++) {
+        glVertexAttrib4fv(INSTANCE_MATRIX_LOCATION + column, &transform.world[column][0]);
+    }
+    for (GLuint column = 0; column < 3; column++) {
+        glVertexAttrib3fv(INSTANCE_NORMAL_LOCATION + column, &transform.normal[column][0]);
+    }
+}
+
+static int8_t packSnorm8(float value) {
+    return (int8_t)std::lround(std::min(1.0f, std::max(-1.0f, value)) * 127.0f);
+}
+
+// Единичной касательной хватает 8 бит на компоненту, знак битангенса точен
+static void packTangents(const StandardMesh& mesh, std::vector<int8_t>& packed) {
+    const VertexTangent* tangents = mesh.tangentData();
+    packed.resize(mesh.tangentCount() * 4);
+    for (size_t i = 0; i < mesh.tangentCount(); i++) {
+        for (int k = 0; k < 3; k++) packed[i * 4 + k] = packSnorm8(tangents[i].direction[k]);
+        packed[i * 4 + 3] = tangents[i].handedness < 0.0f ? -127 : 127;
+    }
+}
+
+static const char* getFormatName(VertexFormat format) {
+    switch (format) {
+        case VertexFormat::FLOAT32: return "float32";
+        case VertexFormat::COMPACT_HALF: return "half";
+        case VertexFormat::COMPACT_SNORM16: return "snorm16";
+    }
+    return "unknown";
+}
+
+// Новое хранилище большего размера; старое содержимое копируется на GPU без чтения на CPU.
+// Через GL_COPY_*_BUFFER, чтобы не трогать привязки текущего VAO
+static GLuint growBuffer(GLuint buffer, size_t oldBytes, size_t newBytes, GLenum usage) {
+    GLuint grown;
+    glGenBuffers(1, &grown);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+    glBufferData(GL_COPY_WRITE_BUFFER, newBytes, nullptr, usage);
+    if (buffer != 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glDeleteBuffers(1, &buffer);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return grown;
+}
+
+bool GpuMeshCache::reserveIndices(size_t bytes, size_t alignment, size_t& offset) {
+    if (indexRanges.allocate(bytes, alignment, offset)) return true;
+
+    size_t oldCapacity = indexRanges.getCapacity();
+    size_t newCapacity = std::max(std::max(oldCapacity * 2, oldCapacity + bytes + alignment), MIN_ARENA_INDEX_BYTES);
+    indexBuffer = growBuffer(indexBuffer, oldCapacity, newCapacity, GL_STATIC_DRAW);
+    indexRanges.grow(newCapacity);
+
+    // Буфер индексов - состояние VAO: новый привязывается в каждую арену
+    for (const VertexArena& arena : arenas) {
+        if (arena.VAO == 0) continue;
+        glBindVertexArray(arena.VAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    }
+    glBindVertexArray(0);
+    return indexRanges.allocate(bytes, alignment, offset);
+}
+
+bool GpuMeshCache::reserveVertices(VertexFormat format, size_t count, size_t& baseVertex) {
+    VertexArena& arena = arenas[(size_t)format];
+    if (arena.vertices.allocate(count, 1, baseVertex)) return true;
+
+    size_t oldCapacity = arena.vertices.getCapacity();
+    size_t newCapacity = std::max(std::max(oldCapacity * 2, oldCapacity + count), MIN_ARENA_VERTICES);
+    size_t stride = getVertexStride(format);
+    // В FLOAT32 живут скинированные меши, их вершины переписываются каждый кадр,
+    // и отображённые меши - DYNAMIC_DRAW ради первых
+    GLenum usage = format == VertexFormat::FLOAT32 ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
+    arena.VBO = growBuffer(arena.VBO, oldCapacity * stride, newCapacity * stride, usage);
+    arena.tangentVBO = growBuffer(arena.tangentVBO, oldCapacity * 4, newCapacity * 4, GL_STATIC_DRAW);
+    arena.vertices.grow(newCapacity);
+
+    // Атрибуты перенаправляются на новые буферы; VAO остаётся прежним, handle мешей не меняются
+    if (arena.VAO == 0) glGenVertexArrays(1, &arena.VAO);
+    glBindVertexArray(arena.VAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, arena.VBO);
+    setupVertexAttributes(format);
+    // Касательные мешей без них не записываются - содержимое их диапазона не определено
+    glBindBuffer(GL_ARRAY_BUFFER, arena.tangentVBO);
+    glVertexAttribPointer(TANGENT_LOCATION, 4, GL_BYTE, GL_TRUE, 4, (void*)0);
+    glEnableVertexAttribArray(TANGENT_LOCATION);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return arena.vertices.allocate(count, 1, baseVertex);
+}
+
+MeshHandle GpuMeshCache::upload(const StandardMesh& mesh) {
+    MeshHandle existing = getHandle(mesh);
+    if (existing != INVALID_MESH_HANDLE) {
+        return existing;
+    }
+    if (mesh.vertexCount() == 0 || mesh.indexCount() == 0) {
+        return INVALID_MESH_HANDLE;
+    }
+
+    // Вершины скинированного меша переписываются каждый кадр - без квантования.
+    // Отображённые из кэша или GLB данные уходят в буфер как есть, без прохода по вершинам
+    bool skinned = !mesh.skin.empty();
+    bool mapped = mesh.mappedVertices != nullptr;
+    VertexFormat format = skinned || mapped ? VertexFormat::FLOAT32 : vertexFormat;
+
+    GpuMesh gpuMesh;
+    gpuMesh.tangentBytes = 0;
+    gpuMesh.format = format;
+    gpuMesh.quantization = identityQuantization();
+    gpuMesh.indexCount = (GLsizei)mesh.indexCount();
+
+    std::vector<CompactVertex> compactVertices;
+    const void* vertexData = mesh.vertexData();
+    if (format != VertexFormat::FLOAT32) {
+        gpuMesh.quantization = quantizeVertices(mesh, format, compactVertices);
+        vertexData = compactVertices.data();
+    }
+    size_t stride = getVertexStride(format);
+    gpuMesh.vertexBytes = mesh.vertexCount() * stride;
+
+    // Меши до 65536 вершин получают 16-битные индексы - base vertex добавляется после выборки индекса.
+    // Отображённые индексы не переупаковываются по той же причине, что и вершины
+    std::vector<uint16_t> shortIndices;
+    const void* indexData = mesh.indexData();
+    size_t indexSize = sizeof(unsigned int);
+    if (!mapped && mesh.vertexCount() <= 65536) {
+        const unsigned int* source = mesh.indexData();
+        shortIndices.assign(source, source + mesh.indexCount());
+        indexData = shortIndices.data();
+        indexSize = sizeof(uint16_t);
+        gpuMesh.indexType = GL_UNSIGNED_SHORT;
+    } else {
+        gpuMesh.indexType = GL_UNSIGNED_INT;
+    }
+    gpuMesh.indexBytes = mesh.indexCount() * indexSize;
+
+    size_t indexOffset, baseVertex;
+    if (!reserveIndices(gpuMesh.indexBytes, indexSize, indexOffset)) {
+        std::cout << "Failed to allocate " << gpuMesh.indexBytes << " index bytes in GPU arena" << std::endl;
+        return INVALID_MESH_HANDLE;
+    }
+    if (!reserveVertices(format, mesh.vertexCount(), baseVertex)) {
+        indexRanges.free(indexOffset, gpuMesh.indexBytes);
+        std::cout << "Failed to allocate " << mesh.vertexCount() << " vertices in GPU arena" << std::endl;
+        return INVALID_MESH_HANDLE;
+    }
+
+    const VertexArena& arena = arenas[(size_t)format];
+    gpuMesh.VAO = arena.VAO;
+    gpuMesh.baseVertex = (GLint)baseVertex;
+    gpuMesh.indexByteOffset = indexOffset;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, arena.VBO);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, baseVertex * stride, gpuMesh.vertexBytes, vertexData);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, indexOffset, gpuMesh.indexBytes, indexData);
+
+    if (mesh.tangentCount() == mesh.vertexCount()) {
+        std::vector<int8_t> packedTangents;
+        packTangents(mesh, packedTangents);
+        gpuMesh.tangentBytes = packedTangents.size();
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, arena.tangentVBO);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, baseVertex * 4, gpuMesh.tangentBytes, packedTangents.data());
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    MeshHandle handle = nextHandle++;
+    meshes[handle] = gpuMesh;
+    handles[&mesh] = handle;
+    owners[handle] = &mesh;
+    residentBytes += gpuMesh.vertexBytes + gpuMesh.indexBytes + gpuMesh.tangentBytes;
+
+    return handle;
+}
+
+MeshHandle GpuMeshCache::getHandle(const StandardMesh& mesh) const {
+    auto it = handles.find(&mesh);
+    return it != handles.end() ? it->second : INVALID_MESH_HANDLE;
+}
+
+const GpuMesh* GpuMeshCache::get(MeshHandle handle) const {
+    auto it = meshes.find(handle);
+    return it != meshes.end() ? &it->second : nullptr;
+}
+
+bool GpuMeshCache::updateVertices(const StandardMesh& mesh, const StandardVertex* vertices, size_t count) {
+    auto it = meshes.find(getHandle(mesh));
+    if (it == meshes.end()) return false;
+
+    const GpuMesh& gpuMesh = it->second;
+    if (gpuMesh.format != VertexFormat::FLOAT32 || count * sizeof(StandardVertex) != gpuMesh.vertexBytes) return false;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, arenas[(size_t)gpuMesh.format].VBO);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, gpuMesh.baseVertex * sizeof(StandardVertex), gpuMesh.vertexBytes, vertices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return true;
+}
+
+bool GpuMeshCache::evict(MeshHandle handle) {
+    auto it = meshes.find(handle);
+    if (it == meshes.end()) return false;
+
+    release(it->second);
+    meshes.erase(it);
+
+    auto owner = owners.find(handle);
+    if (owner != owners.end()) {
+        handles.erase(owner->second);
+        owners.erase(owner);
+    }
+    return true;
+}
+
+bool GpuMeshCache::evict(const StandardMesh& mesh) {
+    return evict(getHandle(mesh));
+}
+
+bool GpuMeshCache::rebind(const StandardMesh& from, const StandardMesh& to) {
+    auto it = handles.find(&from);
+    if (it == handles.end() || handles.count(&to)) return false;
+
+    MeshHandle handle = it->second;
+    handles.erase(it);
+    handles[&to] = handle;
+    owners[handle] = &to;
+    return true;
+}
+
+// Диапазоны возвращаются в арены; сами буферы не сжимаются
+void GpuMeshCache::release(const GpuMesh& gpuMesh) {
+    arenas[(size_t)gpuMesh.format].vertices.free(gpuMesh.baseVertex, gpuMesh.vertexBytes / getVertexStride(gpuMesh.format));
+    indexRanges.free(gpuMesh.indexByteOffset, gpuMesh.indexBytes);
+    residentBytes -= gpuMesh.vertexBytes + gpuMesh.indexBytes + gpuMesh.tangentBytes;
+}
+
+void GpuMeshCache::clear() {
+    for (VertexArena& arena : arenas) {
+        if (arena.VAO) glDeleteVertexArrays(1, &arena.VAO);
+        if (arena.VBO) glDeleteBuffers(1, &arena.VBO);
+        if (arena.tangentVBO) glDeleteBuffers(1, &arena.tangentVBO);
+        arena.VAO = 0;
+        arena.VBO = 0;
+        arena.tangentVBO = 0;
+        arena.vertices.reset(0);
+    }
+    if (indexBuffer) glDeleteBuffers(1, &indexBuffer);
+    indexBuffer = 0;
+    indexRanges.reset(0);
+
+    meshes.clear();
+    handles.clear();
+    owners.clear();
+    residentBytes = 0;
+}
+
+static void printRanges(const char* name, const RangeAllocator& ranges, size_t unitBytes) {
+    std::cout << "  " << name << ": " << ranges.getUsed() * unitBytes / 1024 << "/"
+              << ranges.getCapacity() * unitBytes / 1024 << " KB used, "
+              << ranges.getFreeBlockCount() << " free blocks, largest "
+              << ranges.getLargestFree() * unitBytes / 1024 << " KB, fragmentation "
+              << (int)(ranges.getFragmentation() * 100.0f + 0.5f) << "%" << std::endl;
+}
+
+void GpuMeshCache::printArenaReport() const {
+    std::cout << "GPU arenas:" << std::endl;
+    for (size_t i = 0; i < VERTEX_FORMAT_COUNT; i++) {
+        if (arenas[i].vertices.getCapacity() == 0) continue;
+        VertexFormat format = (VertexFormat)i;
+        printRanges(getFormatName(format), arenas[i].vertices, getVertexStride(format));
+    }
+    if (indexRanges.getCapacity() > 0) printRanges("indices", indexRanges, 1);
+}
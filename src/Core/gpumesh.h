@@ -0,0 +1,107 @@
+#ifndef GPUMESH_H
+#define GPUMESH_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <cstddef>
+#include "parser.h"
+#include "quantize.h"
+#include "rangeallocator.h"
+
+typedef unsigned int MeshHandle;
+const MeshHandle INVALID_MESH_HANDLE = 0;
+
+// Меш - диапазоны в общих буферах арены своего формата
+struct GpuMesh {
+    GLuint VAO;             // VAO арены, общий для всех мешей формата
+    GLint baseVertex;       // для glDrawElementsBaseVertex
+    size_t indexByteOffset; // начало индексов меша в общем буфере индексов
+    GLsizei indexCount;
+    GLenum indexType;
+    size_t vertexBytes;
+    size_t indexBytes;
+    size_t tangentBytes;    // 0 - у меша нет касательных
+    VertexFormat format;
+    QuantizationParams quantization;
+};
+
+void setupVertexAttributes(VertexFormat format);
+
+// Матрица экземпляра - 4 атрибута vec4 подряд, начиная с этой позиции
+const GLuint INSTANCE_MATRIX_LOCATION = 3;
+// Касательная и знак битангенса - vec4 из отдельного буфера, snorm8
+const GLuint TANGENT_LOCATION = 7;
+// Индекс отрисовки для multi-draw indirect - uint с делителем 1
+const GLuint DRAW_INDEX_LOCATION = 8;
+// Матрица нормалей экземпляра - 3 атрибута vec3 подряд
+const GLuint INSTANCE_NORMAL_LOCATION = 9;
+
+// Экземпляр в буфере: мировая матрица и её матрица нормалей, посчитанная на CPU
+struct InstanceTransform {
+    glm::mat4 world;
+    glm::mat3x4 normal; // столбцы vec4, w не читается
+};
+
+// Трансформы экземпляров из буфера (по одному на экземпляр) для текущего VAO
+void bindInstanceTransforms(GLuint buffer, size_t offset);
+void unbindInstanceTransforms();
+// Значение атрибутов при выключенном массиве - для обычных, не инстансированных вызовов
+void setConstantInstanceTransform(const InstanceTransform& transform);
+
+// Кэш резидентных на GPU мешей: загрузка один раз, стабильный handle, явное удаление.
+// Вершины всех мешей одного формата лежат в одном VBO с одним VAO, индексы всех
+// мешей - в одном EBO; диапазоны раздаёт RangeAllocator, при нехватке буфер растёт.
+class GpuMeshCache {
+public:
+    GpuMeshCache();
+
+    MeshHandle upload(const StandardMesh& mesh);
+    MeshHandle getHandle(const StandardMesh& mesh) const;
+    const GpuMesh* get(MeshHandle handle) const;
+
+    // Новые вершины того же количества для скинированного меша (такие хранятся в FLOAT32)
+    bool updateVertices(const StandardMesh& mesh, const StandardVertex* vertices, size_t count);
+
+    bool evict(MeshHandle handle);
+    bool evict(const StandardMesh& mesh);
+    // Переносит handle на другой меш с тем же содержимым без повторной загрузки
+    bool rebind(const StandardMesh& from, const StandardMesh& to);
+    // Удаляет и буферы арен - вызывается при живом контексте
+    void clear();
+
+    // Формат применяется к мешам, загружаемым после вызова; скинированные и отображённые
+    // из кэша или GLB меши всегда FLOAT32
+    void setVertexFormat(VertexFormat format) { vertexFormat = format; }
+    VertexFormat getVertexFormat() const { return vertexFormat; }
+
+    size_t getResidentBytes() const { return residentBytes; }
+    size_t getMeshCount() const { return meshes.size(); }
+    // Заполнение и фрагментация арен
+    void printArenaReport() const;
+
+private:
+    struct VertexArena {
+        GLuint VAO;
+        GLuint VBO;
+        GLuint tangentVBO; // параллельный поток касательных, snorm8 x4 на вершину
+        RangeAllocator vertices; // в вершинах
+    };
+
+    bool reserveVertices(VertexFormat format, size_t count, size_t& baseVertex);
+    bool reserveIndices(size_t bytes, size_t alignment, size_t& offset);
+    void release(const GpuMesh& gpuMesh);
+
+    std::unordered_map<MeshHandle, GpuMesh> meshes;
+    std::unordered_map<const StandardMesh*, MeshHandle> handles;
+    std::unordered_map<MeshHandle, const StandardMesh*> owners; // обратная к handles - evict за O(1)
+    MeshHandle nextHandle;
+    size_t residentBytes;
+    VertexFormat vertexFormat;
+
+    VertexArena arenas[VERTEX_FORMAT_COUNT];
+    GLuint indexBuffer;
+    RangeAllocator indexRanges; // в байтах
+};
+
+#endif
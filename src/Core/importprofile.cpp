@@ -0,0 +1,223 @@
+#include "importprofile.h"
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+static const char* stageNames[(size_t)ImportStage::COUNT] = {
+    "cache_lookup",
+    "read_file",
+    "post_process",
+    "scene_graph",
+    "process_meshes",
+    "convert",
+    "tangents",
+    "optimize",
+    "meshlets",
+    "lods",
+    "bounds",
+    "cache_write",
+    "gpu_upload"
+};
+
+const char* getImportStageName(ImportStage stage) {
+    return stageNames[(size_t)stage];
+}
+
+// Стадии внутри PROCESS_MESHES идут параллельно: у них есть только суммарное время потоков
+static bool isMeshStage(ImportStage stage) {
+    return stage >= ImportStage::CONVERT && stage <= ImportStage::BOUNDS;
+}
+
+double StageSample::elapsedMs() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+AllocationCounters StageSample::allocations() const {
+    AllocationCounters now = getThreadAllocations();
+    AllocationCounters delta = {now.count - allocationsAtStart.count, now.bytes - allocationsAtStart.bytes};
+    return delta;
+}
+
+ImportProfile::ImportProfile() {
+    reset(std::string());
+}
+
+void ImportProfile::reset(const std::string& sourcePath) {
+    source = sourcePath;
+    fromCache = false;
+    threadCount = 1;
+    meshCount = 0;
+    vertexCount = 0;
+    triangleCount = 0;
+    peakRssBytes = 0;
+    cpuMeshBytes = 0;
+    for (auto& stage : stages) stage = ImportStageCost();
+    meshStages.clear();
+}
+
+void ImportProfile::setSceneInfo(size_t meshes, size_t vertices, size_t triangles) {
+    meshCount = meshes;
+    vertexCount = vertices;
+    triangleCount = triangles;
+}
+
+void ImportProfile::setMemory(size_t peakRss, size_t meshBytes) {
+    peakRssBytes = peakRss;
+    cpuMeshBytes = meshBytes;
+}
+
+static void addSample(ImportStageCost& cost, const StageSample& sample, uint64_t outputBytes, bool wall) {
+    double ms = sample.elapsedMs();
+    AllocationCounters allocations = sample.allocations();
+    if (wall) cost.wallMs += ms;
+    cost.cpuMs += ms;
+    cost.allocations += allocations.count;
+    cost.allocatedBytes += allocations.bytes;
+    cost.outputBytes += outputBytes;
+    cost.samples++;
+}
+
+void ImportProfile::record(ImportStage stage, const StageSample& sample, uint64_t outputBytes) {
+    addSample(stages[(size_t)stage], sample, outputBytes, !isMeshStage(stage));
+}
+
+void ImportProfile::beginMeshStages(size_t count) {
+    meshStages.assign(count * (size_t)ImportStage::COUNT, ImportStageCost());
+}
+
+void ImportProfile::recordMesh(size_t meshIndex, ImportStage stage, const StageSample& sample, uint64_t outputBytes) {
+    addSample(meshStages[meshIndex * (size_t)ImportStage::COUNT + (size_t)stage], sample, outputBytes, false);
+}
+
+void ImportProfile::finishMeshStages() {
+    // Снимок вызывающего потока не видит выделений рабочих потоков,
+    // поэтому общий этап получает суммы своих частей
+    ImportStageCost& umbrella = stages[(size_t)ImportStage::PROCESS_MESHES];
+    umbrella.cpuMs = 0.0;
+    umbrella.allocations = 0;
+    umbrella.allocatedBytes = 0;
+    umbrella.outputBytes = 0;
+
+    for (size_t i = 0; i < meshStages.size(); i++) {
+        const ImportStageCost& mesh = meshStages[i];
+        ImportStageCost& total = stages[i % (size_t)ImportStage::COUNT];
+        total.cpuMs += mesh.cpuMs;
+        total.allocations += mesh.allocations;
+        total.allocatedBytes += mesh.allocatedBytes;
+        total.outputBytes += mesh.outputBytes;
+        total.samples += mesh.samples;
+
+        umbrella.cpuMs += mesh.cpuMs;
+        umbrella.allocations += mesh.allocations;
+        umbrella.allocatedBytes += mesh.allocatedBytes;
+    }
+    meshStages.clear();
+}
+
+void ImportProfile::merge(ImportStage stage, const ImportStageCost& cost) {
+    ImportStageCost& total = stages[(size_t)stage];
+    total.wallMs += cost.wallMs;
+    total.cpuMs += cost.cpuMs;
+    total.allocations += cost.allocations;
+    total.allocatedBytes += cost.allocatedBytes;
+    total.outputBytes += cost.outputBytes;
+    total.samples += cost.samples;
+}
+
+double ImportProfile::getTotalMs() const {
+    double total = 0.0;
+    for (size_t i = 0; i < (size_t)ImportStage::COUNT; i++) {
+        total += stages[i].wallMs;
+    }
+    return total;
+}
+
+static std::string escapeJson(const std::string& value) {
+    std::ostringstream out;
+    for (char c : value) {
+        switch (c) {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec;
+                } else {
+                    out << c;
+                }
+        }
+    }
+    return out.str();
+}
+
+std::string ImportProfile::toJson() const {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << "{\n";
+    out << "  \"source\": \"" << escapeJson(source) << "\",\n";
+    out << "  \"fromCache\": " << (fromCache ? "true" : "false") << ",\n";
+    out << "  \"threads\": " << threadCount << ",\n";
+    out << "  \"meshes\": " << meshCount << ",\n";
+    out << "  \"vertices\": " << vertexCount << ",\n";
+    out << "  \"triangles\": " << triangleCount << ",\n";
+    out << "  \"totalMs\": " << getTotalMs() << ",\n";
+    out << "  \"peakRssBytes\": " << peakRssBytes << ",\n";
+    out << "  \"cpuMeshBytes\": " << cpuMeshBytes << ",\n";
+    out << "  \"stages\": [";
+
+    bool first = true;
+    for (size_t i = 0; i < (size_t)ImportStage::COUNT; i++) {
+        const ImportStageCost& cost = stages[i];
+        if (cost.samples == 0) continue;
+
+        ImportStage stage = (ImportStage)i;
+        out << (first ? "\n" : ",\n");
+        out << "    {\"name\": \"" << getImportStageName(stage) << "\"";
+        out << ", \"parallel\": " << (isMeshStage(stage) ? "true" : "false");
+        if (!isMeshStage(stage)) out << ", \"wallMs\": " << cost.wallMs;
+        out << ", \"cpuMs\": " << cost.cpuMs;
+        out << ", \"allocations\": " << cost.allocations;
+        out << ", \"allocatedBytes\": " << cost.allocatedBytes;
+        out << ", \"outputBytes\": " << cost.outputBytes << "}";
+        first = false;
+    }
+    out << "\n  ]\n}\n";
+    return out.str();
+}
+
+std::string ImportProfile::summary() const {
+    uint64_t allocations = 0, allocatedBytes = 0;
+    for (size_t i = 0; i < (size_t)ImportStage::COUNT; i++) {
+        // Вложенные стадии уже учтены в PROCESS_MESHES
+        if (isMeshStage((ImportStage)i)) continue;
+        allocations += stages[i].allocations;
+        allocatedBytes += stages[i].allocatedBytes;
+    }
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    out << "Import profile: " << source << " " << getTotalMs() << " ms" << (fromCache ? " (cache)" : "") << " [";
+    bool first = true;
+    for (size_t i = 0; i < (size_t)ImportStage::COUNT; i++) {
+        if (stages[i].samples == 0) continue;
+        ImportStage stage = (ImportStage)i;
+        out << (first ? "" : ", ") << getImportStageName(stage) << " "
+            << (isMeshStage(stage) ? stages[i].cpuMs : stages[i].wallMs) << (isMeshStage(stage) ? " cpu" : "");
+        first = false;
+    }
+    out << "] " << allocations << " allocs, " << allocatedBytes / (1024 * 1024) << " MB allocated, peak RSS "
+        << peakRssBytes / (1024 * 1024) << " MB";
+    return out.str();
+}
+
+bool ImportProfile::writeJson(const std::string& path) const {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        std::cout << "Failed to write import profile: " << path << std::endl;
+        return false;
+    }
+    out << toJson();
+    return (bool)out;
+}
@@ -0,0 +1,91 @@
+#ifndef IMPORTPROFILE_H
+#define IMPORTPROFILE_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include "memstats.h"
+
+enum class ImportStage {
+    CACHE_LOOKUP,   // хэш исходника и чтение бинарного кэша
+    READ_FILE,      // разбор файла Assimp
+    POST_PROCESS,   // триангуляция, нормали и т.д.
+    SCENE_GRAPH,    // дедупликация мешей и обход узлов
+    PROCESS_MESHES, // весь параллельный этап, стадии ниже - его части
+    CONVERT,
+    TANGENTS,       // нормали (если их не было) и касательные
+    OPTIMIZE,
+    MESHLETS,
+    LODS,
+    BOUNDS,
+    CACHE_WRITE,
+    GPU_UPLOAD,
+    COUNT
+};
+
+const char* getImportStageName(ImportStage stage);
+
+struct ImportStageCost {
+    double wallMs;
+    double cpuMs;           // для параллельных стадий - сумма по потокам
+    uint64_t allocations;
+    uint64_t allocatedBytes;
+    uint64_t outputBytes;   // объём данных, которые стадия произвела
+    uint32_t samples;
+};
+
+// Снимок времени и счётчиков выделений текущего потока
+class StageSample {
+public:
+    StageSample() : start(std::chrono::steady_clock::now()), allocationsAtStart(getThreadAllocations()) {}
+
+    double elapsedMs() const;
+    AllocationCounters allocations() const;
+
+private:
+    std::chrono::steady_clock::time_point start;
+    AllocationCounters allocationsAtStart;
+};
+
+// Профиль импорта одной модели. Последовательные стадии пишутся через record(),
+// параллельные - через recordMesh() в слот своего меша без синхронизации
+// и сводятся в finishMeshStages().
+class ImportProfile {
+public:
+    ImportProfile();
+
+    void reset(const std::string& source);
+    void setFromCache(bool cached) { fromCache = cached; }
+    void setThreadCount(size_t threads) { threadCount = threads; }
+    void setSceneInfo(size_t meshes, size_t vertices, size_t triangles);
+    void setMemory(size_t peakRss, size_t cpuMeshBytes);
+
+    void record(ImportStage stage, const StageSample& sample, uint64_t outputBytes = 0);
+    void beginMeshStages(size_t meshCount);
+    void recordMesh(size_t meshIndex, ImportStage stage, const StageSample& sample, uint64_t outputBytes = 0);
+    void finishMeshStages();
+    // Добавляет стоимость, собранную другим профилем (например, в другом потоке)
+    void merge(ImportStage stage, const ImportStageCost& cost);
+
+    const ImportStageCost& getStage(ImportStage stage) const { return stages[(size_t)stage]; }
+    double getTotalMs() const;
+
+    std::string toJson() const;
+    std::string summary() const;
+    bool writeJson(const std::string& path) const;
+
+private:
+    std::string source;
+    bool fromCache;
+    size_t threadCount;
+    size_t meshCount;
+    size_t vertexCount;
+    size_t triangleCount;
+    size_t peakRssBytes;
+    size_t cpuMeshBytes;
+    ImportStageCost stages[(size_t)ImportStage::COUNT];
+    std::vector<ImportStageCost> meshStages; // meshCount * COUNT
+};
+
+#endif
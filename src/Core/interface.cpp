@@ -3,7 +3,7 @@
 #include <iostream>
 
 Interface::Interface() 
-    : shaderProgram(0), borderVAO(0), borderVBO(0), 
+    : borderColor({-1}), borderVAO(0), borderVBO(0), 
       screenWidth(800), screenHeight(600), window(nullptr) {}
 
 Interface::~Interface() {
@@ -14,22 +14,9 @@ void Interface::initialize(GLFWwindow* window) {
     this->window = window;
     
     // Компилируем шейдеры
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, nullptr);
-    glCompileShader(vertexShader);
-    
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, nullptr);
-    glCompileShader(fragmentShader);
-    
-    // Создаем программу
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    if (program.build("interface", vertexShaderSource, fragmentShaderSource)) {
+        borderColor = program.uniform<glm::vec3>("borderColor");
+    }
     
     // Получаем размеры окна
     glfwGetWindowSize(window, &screenWidth, &screenHeight);
@@ -102,17 +89,16 @@ void Interface::createBorderVAO() {
 }
 
 void Interface::render() {
-    if (!shaderProgram) return;
+    if (!program.isValid()) return;
     
     // Сохраняем текущие настройки OpenGL
     glDisable(GL_DEPTH_TEST);
     
     // Используем шейдер интерфейса
-    glUseProgram(shaderProgram);
+    program.use();
     
-    // Устанавливаем цвет обводки (синий)
-    GLint colorLoc = glGetUniformLocation(shaderProgram, "borderColor");
-    glUniform3f(colorLoc, 0.0f, 0.5f, 1.0f); // Синий цвет
+    // Устанавливаем цвет обводки (синий); со второго кадра запись отбрасывает кэш
+    program.set(borderColor, glm::vec3(0.0f, 0.5f, 1.0f));
     
     // Рисуем обводку
     glBindVertexArray(borderVAO);
@@ -139,10 +125,7 @@ void Interface::cleanup() {
         borderVBO = 0;
     }
     
-    if (shaderProgram) {
-        glDeleteProgram(shaderProgram);
-        shaderProgram = 0;
-    }
+    program.destroy();
 }
 
 void Interface::setWindowSize(int width, int height) {
@@ -3,6 +3,7 @@
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include "shaderprogram.h"
 
 class Interface {
 public:
@@ -18,7 +19,8 @@ public:
 private:
     void createBorderVAO();
     
-    GLuint shaderProgram;
+    ShaderProgram program;
+    ShaderUniform<glm::vec3> borderColor;
     GLuint borderVAO;
     GLuint borderVBO;
     
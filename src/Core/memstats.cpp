@@ -0,0 +1,133 @@
+#include "memstats.h"
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// Счётчики на поток: без атомиков и блокировок, operator new остаётся дешёвым
+static thread_local AllocationCounters threadAllocations = {0, 0};
+
+AllocationCounters getThreadAllocations() {
+    return threadAllocations;
+}
+
+// Как у стандартного operator new: при нехватке памяти вызывается new_handler,
+// пока он есть и не освободил достаточно
+static void* countedAllocate(size_t size, size_t alignment) {
+    if (size == 0) size = 1;
+    for (;;) {
+        void* p = nullptr;
+        if (alignment <= alignof(std::max_align_t)) {
+            p = std::malloc(size);
+        } else {
+#ifdef _WIN32
+            p = _aligned_malloc(size, alignment);
+#else
+            if (posix_memalign(&p, alignment, size) != 0) p = nullptr;
+#endif
+        }
+        if (p) {
+            threadAllocations.count++;
+            threadAllocations.bytes += size;
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+static void countedFree(void* p, size_t alignment) noexcept {
+#ifdef _WIN32
+    if (alignment > alignof(std::max_align_t)) {
+        _aligned_free(p);
+        return;
+    }
+#else
+    (void)alignment;
+#endif
+    std::free(p);
+}
+
+static void* countedAllocateNoThrow(size_t size, size_t alignment) noexcept {
+    try {
+        return countedAllocate(size, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new(size_t size) { return countedAllocate(size, 0); }
+void* operator new[](size_t size) { return countedAllocate(size, 0); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return countedAllocateNoThrow(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return countedAllocateNoThrow(size, 0); }
+
+void operator delete(void* p) noexcept { countedFree(p, 0); }
+void operator delete[](void* p) noexcept { countedFree(p, 0); }
+void operator delete(void* p, size_t) noexcept { countedFree(p, 0); }
+void operator delete[](void* p, size_t) noexcept { countedFree(p, 0); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { countedFree(p, 0); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { countedFree(p, 0); }
+
+// Перевыровненные типы (alignas больше max_align_t) идут через эти перегрузки;
+// освобождать их нужно парной функцией - на Windows это _aligned_free
+void* operator new(size_t size, std::align_val_t alignment) { return countedAllocate(size, (size_t)alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return countedAllocate(size, (size_t)alignment); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return countedAllocateNoThrow(size, (size_t)alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return countedAllocateNoThrow(size, (size_t)alignment);
+}
+
+void operator delete(void* p, std::align_val_t alignment) noexcept { countedFree(p, (size_t)alignment); }
+void operator delete[](void* p, std::align_val_t alignment) noexcept { countedFree(p, (size_t)alignment); }
+void operator delete(void* p, size_t, std::align_val_t alignment) noexcept { countedFree(p, (size_t)alignment); }
+void operator delete[](void* p, size_t, std::align_val_t alignment) noexcept { countedFree(p, (size_t)alignment); }
+void operator delete(void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept { countedFree(p, (size_t)alignment); }
+void operator delete[](void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept { countedFree(p, (size_t)alignment); }
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+
+size_t getCurrentRss() {
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return (size_t)counters.WorkingSetSize;
+}
+
+size_t getPeakRss() {
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return (size_t)counters.PeakWorkingSetSize;
+}
+
+#else
+#include <fstream>
+#include <string>
+
+static size_t readStatusField(const char* field) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    std::string prefix = std::string(field) + ":";
+    while (std::getline(status, line)) {
+        if (line.compare(0, prefix.size(), prefix) == 0) {
+            return (size_t)std::stoull(line.substr(prefix.size())) * 1024;
+        }
+    }
+    return 0;
+}
+
+size_t getCurrentRss() {
+    return readStatusField("VmRSS");
+}
+
+size_t getPeakRss() {
+    return readStatusField("VmHWM");
+}
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef MEMSTATS_H
+#define MEMSTATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Резидентная память процесса в байтах (0, если платформа не поддерживается)
+size_t getCurrentRss();
+size_t getPeakRss();
+
+struct AllocationCounters {
+    uint64_t count;
+    uint64_t bytes;
+};
+
+// Выделения через operator new в текущем потоке с момента его запуска.
+// Разность двух снимков даёт число и объём выделений участка кода.
+AllocationCounters getThreadAllocations();
+
+#endif
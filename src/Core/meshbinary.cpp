@@ -0,0 +1,284 @@
+#include "meshbinary.h"
+#include "bounds.h"
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <glm/gtc/type_ptr.hpp>
+
+static const uint64_t CACHE_ALIGNMENT = 16;
+
+static uint64_t alignUp(uint64_t value) {
+    return (value + CACHE_ALIGNMENT - 1) & ~(CACHE_ALIGNMENT - 1);
+}
+
+static void writePadding(std::ofstream& out, uint64_t from, uint64_t to) {
+    static const char zeros[CACHE_ALIGNMENT] = {};
+    if (to > from) out.write(zeros, (std::streamsize)(to - from));
+}
+
+std::string MeshBinaryCache::getCachePath(const std::string& sourcePath) {
+    return sourcePath + ".tmc";
+}
+
+bool MeshBinaryCache::hashFile(const std::string& path, uint64_t& hash, uint64_t& size) {
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    hash = hashBytes(file.data(), file.size());
+    size = file.size();
+    return true;
+}
+
+uint64_t MeshBinaryCache::hashBytes(const void* data, size_t size, uint64_t seed) {
+    uint64_t h = seed;
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        h ^= bytes[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+bool MeshBinaryCache::isUpToDate(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize, uint64_t optionsHash) {
+    std::ifstream in(cachePath, std::ios::binary);
+    MeshCacheHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+
+    return header.magic == MESH_CACHE_MAGIC && header.version == MESH_CACHE_VERSION &&
+           header.sourceHash == sourceHash && header.sourceSize == sourceSize &&
+           header.optionsHash == optionsHash && header.vertexStride == sizeof(StandardVertex);
+}
+
+bool MeshBinaryCache::save(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize, uint64_t optionsHash,
+                           const std::vector<StandardMesh>& meshes, const SceneGraph& sceneGraph) {
+    MeshCacheHeader header = {};
+    header.magic = MESH_CACHE_MAGIC;
+    header.version = MESH_CACHE_VERSION;
+    header.sourceHash = sourceHash;
+    header.sourceSize = sourceSize;
+    header.optionsHash = optionsHash;
+    header.meshCount = (uint32_t)meshes.size();
+    header.vertexStride = sizeof(StandardVertex);
+
+    std::vector<MeshCacheEntry> table(meshes.size(), MeshCacheEntry());
+    uint64_t vertexBytes = 0;
+    uint64_t indexBytes = 0;
+    uint64_t meshletBytes = 0;
+    uint64_t tangentBytes = 0;
+    for (size_t i = 0; i < meshes.size(); i++) {
+        table[i].vertexOffset = vertexBytes;
+        table[i].vertexCount = meshes[i].vertexCount();
+        table[i].indexOffset = indexBytes;
+        table[i].indexCount = meshes[i].indexCount();
+        table[i].meshletOffset = meshletBytes;
+        table[i].meshletCount = meshes[i].meshletCount();
+        table[i].tangentOffset = tangentBytes;
+        table[i].tangentCount = meshes[i].tangentCount();
+        table[i].lodCount = (uint32_t)std::min(meshes[i].lods.size(), (size_t)MAX_MESH_LODS);
+        std::copy(meshes[i].lods.begin(), meshes[i].lods.begin() + table[i].lodCount, table[i].lods);
+        table[i].bounds = meshes[i].bounds;
+        table[i].contentHash = meshes[i].contentHash;
+        vertexBytes += table[i].vertexCount * header.vertexStride;
+        indexBytes += table[i].indexCount * sizeof(unsigned int);
+        meshletBytes += table[i].meshletCount * sizeof(Meshlet);
+        tangentBytes += table[i].tangentCount * sizeof(VertexTangent);
+    }
+
+    header.meshTableOffset = alignUp(sizeof(MeshCacheHeader));
+    header.vertexBlobOffset = alignUp(header.meshTableOffset + table.size() * sizeof(MeshCacheEntry));
+    header.vertexBlobSize = vertexBytes;
+    header.indexBlobOffset = alignUp(header.vertexBlobOffset + vertexBytes);
+    header.indexBlobSize = indexBytes;
+    header.meshletBlobOffset = alignUp(header.indexBlobOffset + indexBytes);
+    header.meshletBlobSize = meshletBytes;
+    header.tangentBlobOffset = alignUp(header.meshletBlobOffset + meshletBytes);
+    header.tangentBlobSize = tangentBytes;
+    header.nodeTableOffset = alignUp(header.tangentBlobOffset + tangentBytes);
+    header.nodeCount = sceneGraph.getNodeCount();
+    header.instanceTableOffset = alignUp(header.nodeTableOffset + header.nodeCount * sizeof(SceneNodeRecord));
+    header.instanceCount = sceneGraph.getMeshInstances().size();
+
+    for (size_t i = 0; i < meshes.size(); i++) {
+        table[i].vertexOffset += header.vertexBlobOffset;
+        table[i].indexOffset += header.indexBlobOffset;
+        table[i].meshletOffset += header.meshletBlobOffset;
+        table[i].tangentOffset += header.tangentBlobOffset;
+    }
+
+    BoundsBuilder::computeScene(meshes, sceneGraph, header.sceneBounds);
+
+    // Пишем во временный файл, чтобы оборванная запись не оставила битый кэш
+    std::string tempPath = cachePath + ".tmp";
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cout << "Failed to write mesh cache: " << cachePath << std::endl;
+        return false;
+    }
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writePadding(out, sizeof(header), header.meshTableOffset);
+    out.write(reinterpret_cast<const char*>(table.data()), (std::streamsize)(table.size() * sizeof(MeshCacheEntry)));
+    writePadding(out, header.meshTableOffset + table.size() * sizeof(MeshCacheEntry), header.vertexBlobOffset);
+    for (const auto& mesh : meshes) {
+        out.write(reinterpret_cast<const char*>(mesh.vertexData()),
+                  (std::streamsize)(mesh.vertexCount() * header.vertexStride));
+    }
+    writePadding(out, header.vertexBlobOffset + vertexBytes, header.indexBlobOffset);
+    for (const auto& mesh : meshes) {
+        out.write(reinterpret_cast<const char*>(mesh.indexData()),
+                  (std::streamsize)(mesh.indexCount() * sizeof(unsigned int)));
+    }
+    writePadding(out, header.indexBlobOffset + indexBytes, header.meshletBlobOffset);
+    for (const auto& mesh : meshes) {
+        out.write(reinterpret_cast<const char*>(mesh.meshletData()),
+                  (std::streamsize)(mesh.meshletCount() * sizeof(Meshlet)));
+    }
+    writePadding(out, header.meshletBlobOffset + meshletBytes, header.tangentBlobOffset);
+    for (const auto& mesh : meshes) {
+        out.write(reinterpret_cast<const char*>(mesh.tangentData()),
+                  (std::streamsize)(mesh.tangentCount() * sizeof(VertexTangent)));
+    }
+    writePadding(out, header.tangentBlobOffset + tangentBytes, header.nodeTableOffset);
+    for (uint32_t i = 0; i < header.nodeCount; i++) {
+        SceneNodeRecord record = {};
+        record.parent = sceneGraph.getParent(i);
+        std::memcpy(record.local, glm::value_ptr(sceneGraph.getLocalTransform(i)), sizeof(record.local));
+        std::strncpy(record.name, sceneGraph.getName(i).c_str(), SCENE_NODE_NAME_LENGTH - 1);
+        out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+    writePadding(out, header.nodeTableOffset + header.nodeCount * sizeof(SceneNodeRecord), header.instanceTableOffset);
+    out.write(reinterpret_cast<const char*>(sceneGraph.getMeshInstances().data()),
+              (std::streamsize)(header.instanceCount * sizeof(MeshInstance)));
+    out.close();
+
+    if (!out) {
+        std::remove(tempPath.c_str());
+        std::cout << "Failed to write mesh cache: " << cachePath << std::endl;
+        return false;
+    }
+
+    std::remove(cachePath.c_str());
+    if (std::rename(tempPath.c_str(), cachePath.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+// count элементов по stride байт от offset помещаются в файл; без переполнения при огромных count
+static bool rangeFits(uint64_t offset, uint64_t count, uint64_t stride, uint64_t fileSize) {
+    return offset <= fileSize && count <= (fileSize - offset) / stride;
+}
+
+// Диапазоны внутри меша: уровни LOD и кластеры - в пределах его индексов,
+// индексы - в пределах его вершин. Иначе отрисовка вышла бы за меш в общих буферах
+static bool validateMeshContents(const MeshCacheEntry& entry, const unsigned char* base) {
+    for (uint32_t k = 0; k < entry.lodCount; k++) {
+        if ((uint64_t)entry.lods[k].indexOffset + entry.lods[k].indexCount > entry.indexCount ||
+            entry.lods[k].indexCount % 3 != 0) {
+            return false;
+        }
+    }
+
+    const Meshlet* meshlets = reinterpret_cast<const Meshlet*>(base + entry.meshletOffset);
+    for (uint64_t k = 0; k < entry.meshletCount; k++) {
+        if ((uint64_t)meshlets[k].indexOffset + (uint64_t)meshlets[k].triangleCount * 3 > entry.indexCount) return false;
+    }
+
+    const unsigned int* indices = reinterpret_cast<const unsigned int*>(base + entry.indexOffset);
+    unsigned int maxIndex = 0;
+    for (uint64_t k = 0; k < entry.indexCount; k++) {
+        maxIndex = std::max(maxIndex, indices[k]);
+    }
+    return entry.indexCount == 0 || maxIndex < entry.vertexCount;
+}
+
+bool MeshBinaryCache::load(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize, uint64_t optionsHash,
+                           std::vector<StandardMesh>& meshes, SceneGraph& sceneGraph, MeshBounds& sceneBounds,
+                           std::shared_ptr<MappedFile>& mapping) {
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(cachePath)) return false;
+    if (file->size() < sizeof(MeshCacheHeader)) return false;
+
+    const unsigned char* base = file->data();
+    const MeshCacheHeader* header = reinterpret_cast<const MeshCacheHeader*>(base);
+
+    if (header->magic != MESH_CACHE_MAGIC || header->version != MESH_CACHE_VERSION) return false;
+    if (header->sourceHash != sourceHash || header->sourceSize != sourceSize) return false;
+    // Кэш собран с другими настройками импорта - его данные не те, что дал бы импорт сейчас
+    if (header->optionsHash != optionsHash) return false;
+    if (header->vertexStride != sizeof(StandardVertex)) return false;
+
+    uint64_t fileSize = file->size();
+    if (!rangeFits(header->meshTableOffset, header->meshCount, sizeof(MeshCacheEntry), fileSize) ||
+        !rangeFits(header->vertexBlobOffset, header->vertexBlobSize, 1, fileSize) ||
+        !rangeFits(header->indexBlobOffset, header->indexBlobSize, 1, fileSize) ||
+        !rangeFits(header->meshletBlobOffset, header->meshletBlobSize, 1, fileSize) ||
+        !rangeFits(header->tangentBlobOffset, header->tangentBlobSize, 1, fileSize) ||
+        !rangeFits(header->nodeTableOffset, header->nodeCount, sizeof(SceneNodeRecord), fileSize) ||
+        !rangeFits(header->instanceTableOffset, header->instanceCount, sizeof(MeshInstance), fileSize)) {
+        std::cout << "Mesh cache is truncated: " << cachePath << std::endl;
+        return false;
+    }
+
+    const MeshCacheEntry* table = reinterpret_cast<const MeshCacheEntry*>(base + header->meshTableOffset);
+
+    std::vector<StandardMesh> loaded(header->meshCount);
+    for (uint32_t i = 0; i < header->meshCount; i++) {
+        const MeshCacheEntry& entry = table[i];
+        if (!rangeFits(entry.vertexOffset, entry.vertexCount, header->vertexStride, fileSize) ||
+            !rangeFits(entry.indexOffset, entry.indexCount, sizeof(unsigned int), fileSize) ||
+            !rangeFits(entry.meshletOffset, entry.meshletCount, sizeof(Meshlet), fileSize) ||
+            !rangeFits(entry.tangentOffset, entry.tangentCount, sizeof(VertexTangent), fileSize) ||
+            (entry.tangentCount != 0 && entry.tangentCount != entry.vertexCount) ||
+            entry.lodCount > MAX_MESH_LODS) {
+            std::cout << "Mesh cache is truncated: " << cachePath << std::endl;
+            return false;
+        }
+        if (!validateMeshContents(entry, base)) {
+            std::cout << "Mesh cache is corrupt (mesh " << i << " has out-of-range indices): " << cachePath << std::endl;
+            return false;
+        }
+
+        StandardMesh& mesh = loaded[i];
+        mesh.mappedVertices = reinterpret_cast<const StandardVertex*>(base + entry.vertexOffset);
+        mesh.mappedVertexCount = (size_t)entry.vertexCount;
+        mesh.mappedIndices = reinterpret_cast<const unsigned int*>(base + entry.indexOffset);
+        mesh.mappedIndexCount = (size_t)entry.indexCount;
+        mesh.mappedMeshlets = entry.meshletCount ? reinterpret_cast<const Meshlet*>(base + entry.meshletOffset) : nullptr;
+        mesh.mappedMeshletCount = (size_t)entry.meshletCount;
+        mesh.mappedTangents = entry.tangentCount ? reinterpret_cast<const VertexTangent*>(base + entry.tangentOffset) : nullptr;
+        mesh.mappedTangentCount = (size_t)entry.tangentCount;
+        mesh.lods.assign(entry.lods, entry.lods + entry.lodCount);
+        mesh.bounds = entry.bounds;
+        mesh.contentHash = entry.contentHash;
+    }
+
+    // Иерархия небольшая - копируем её, а не держим указатели в файл
+    SceneGraph graph;
+    const SceneNodeRecord* nodes = reinterpret_cast<const SceneNodeRecord*>(base + header->nodeTableOffset);
+    for (uint64_t i = 0; i < header->nodeCount; i++) {
+        // Родитель - раньше узла (порядок обхода в глубину); иначе addNode читал бы вне массивов
+        int32_t parent = nodes[i].parent;
+        if (parent != SCENE_NO_PARENT && (parent < 0 || (uint64_t)parent >= i)) {
+            std::cout << "Mesh cache is corrupt (node " << i << " has an invalid parent): " << cachePath << std::endl;
+            return false;
+        }
+        std::string name(nodes[i].name, strnlen(nodes[i].name, SCENE_NODE_NAME_LENGTH));
+        graph.addNode(nodes[i].parent, glm::make_mat4(nodes[i].local), name);
+    }
+    const MeshInstance* instances = reinterpret_cast<const MeshInstance*>(base + header->instanceTableOffset);
+    for (uint64_t i = 0; i < header->instanceCount; i++) {
+        if (instances[i].node >= header->nodeCount || instances[i].mesh >= header->meshCount) return false;
+        graph.addMeshInstance(instances[i].node, instances[i].mesh);
+    }
+
+    meshes.swap(loaded);
+    sceneGraph = graph;
+    // Границы сцены посчитаны при записи - обходить меши заново не нужно
+    sceneBounds = header->sceneBounds;
+    mapping = file;
+    return true;
+}
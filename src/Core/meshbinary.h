@@ -0,0 +1,81 @@
+#ifndef MESHBINARY_H
+#define MESHBINARY_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include "parser.h"
+#include "mappedfile.h"
+
+const uint32_t MESH_CACHE_MAGIC = 0x48534D54; // "TMSH"
+const uint32_t MESH_CACHE_VERSION = 11;
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+
+struct MeshCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceHash;
+    uint64_t sourceSize;
+    uint64_t optionsHash; // настройки импорта, от которых зависят данные кэша
+    uint32_t meshCount;
+    uint32_t vertexStride;
+    uint64_t meshTableOffset;
+    uint64_t vertexBlobOffset;
+    uint64_t vertexBlobSize;
+    uint64_t indexBlobOffset;
+    uint64_t indexBlobSize;
+    uint64_t meshletBlobOffset;
+    uint64_t meshletBlobSize;
+    uint64_t tangentBlobOffset;
+    uint64_t tangentBlobSize;
+    uint64_t nodeTableOffset;
+    uint64_t nodeCount;
+    uint64_t instanceTableOffset;
+    uint64_t instanceCount;
+    MeshBounds sceneBounds; // с мировыми матрицами узлов
+};
+
+const size_t SCENE_NODE_NAME_LENGTH = 60;
+
+struct SceneNodeRecord {
+    int32_t parent;
+    float local[16];
+    char name[SCENE_NODE_NAME_LENGTH]; // обрезается, всегда с завершающим нулём
+};
+
+struct MeshCacheEntry {
+    uint64_t vertexOffset;
+    uint64_t vertexCount;
+    uint64_t indexOffset;
+    uint64_t indexCount;
+    uint64_t meshletOffset;
+    uint64_t meshletCount;
+    uint64_t tangentOffset;
+    uint64_t tangentCount; // 0 или vertexCount
+    uint32_t lodCount;
+    MeshLod lods[MAX_MESH_LODS];
+    MeshBounds bounds;
+    uint64_t contentHash;
+};
+
+// Версионированный бинарный кэш мешей рядом с исходным файлом (<model>.tmc)
+class MeshBinaryCache {
+public:
+    static std::string getCachePath(const std::string& sourcePath);
+    static bool hashFile(const std::string& path, uint64_t& hash, uint64_t& size);
+    // FNV-1a 64; seed позволяет хэшировать несколько блоков подряд
+    static uint64_t hashBytes(const void* data, size_t size, uint64_t seed = FNV_OFFSET_BASIS);
+
+    // Кэш существует и собран из исходника с тем же содержимым и с теми же настройками
+    // импорта (ModelParser::getCacheOptionsHash)
+    static bool isUpToDate(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize, uint64_t optionsHash);
+
+    static bool save(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize, uint64_t optionsHash,
+                     const std::vector<StandardMesh>& meshes, const SceneGraph& sceneGraph);
+    static bool load(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize, uint64_t optionsHash,
+                     std::vector<StandardMesh>& meshes, SceneGraph& sceneGraph, MeshBounds& sceneBounds,
+                     std::shared_ptr<MappedFile>& mapping);
+};
+
+#endif
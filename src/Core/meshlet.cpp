@@ -0,0 +1,127 @@
+#include "meshlet.h"
+#include "frustum.h"
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+void MeshletBuilder::build(StandardMesh& mesh, unsigned int maxVertices, unsigned int maxTriangles) {
+    mesh.meshlets.clear();
+
+    size_t triangleCount = mesh.indices.size() / 3;
+    if (triangleCount == 0 || mesh.indices.size() % 3 != 0) return;
+
+    // marker[v] - номер кластера, в котором вершина уже учтена
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> marker(mesh.vertexCount(), unused);
+    unsigned int meshletId = 0;
+
+    Meshlet current = {};
+    for (size_t t = 0; t < triangleCount; t++) {
+        const unsigned int* tri = &mesh.indices[t * 3];
+
+        unsigned int newVertices = 0;
+        for (int k = 0; k < 3; k++) {
+            bool duplicate = (k > 0 && tri[k] == tri[0]) || (k > 1 && tri[k] == tri[1]);
+            if (marker[tri[k]] != meshletId && !duplicate) newVertices++;
+        }
+
+        if (current.triangleCount > 0 &&
+            (current.vertexCount + newVertices > maxVertices || current.triangleCount + 1 > maxTriangles)) {
+            computeBounds(current, mesh);
+            mesh.meshlets.push_back(current);
+
+            meshletId++;
+            current = Meshlet();
+            current.indexOffset = (unsigned int)(t * 3);
+            newVertices = 3;
+            if (tri[1] == tri[0]) newVertices--;
+            if (tri[2] == tri[0] || tri[2] == tri[1]) newVertices--;
+        }
+
+        for (int k = 0; k < 3; k++) marker[tri[k]] = meshletId;
+        current.vertexCount += newVertices;
+        current.triangleCount++;
+    }
+
+    computeBounds(current, mesh);
+    mesh.meshlets.push_back(current);
+    mesh.meshlets.shrink_to_fit();
+}
+
+void MeshletBuilder::computeBounds(Meshlet& meshlet, const StandardMesh& mesh) {
+    const unsigned int* indices = &mesh.indices[meshlet.indexOffset];
+    const StandardVertex* vertices = mesh.vertexData();
+    size_t indexCount = (size_t)meshlet.triangleCount * 3;
+
+    float minP[3], maxP[3];
+    for (int k = 0; k < 3; k++) {
+        minP[k] = maxP[k] = vertices[indices[0]].position[k];
+    }
+    for (size_t i = 1; i < indexCount; i++) {
+        const float* p = vertices[indices[i]].position;
+        for (int k = 0; k < 3; k++) {
+            minP[k] = std::min(minP[k], p[k]);
+            maxP[k] = std::max(maxP[k], p[k]);
+        }
+    }
+
+    float radiusSq = 0.0f;
+    for (int k = 0; k < 3; k++) meshlet.center[k] = (minP[k] + maxP[k]) * 0.5f;
+    for (size_t i = 0; i < indexCount; i++) {
+        const float* p = vertices[indices[i]].position;
+        float dx = p[0] - meshlet.center[0], dy = p[1] - meshlet.center[1], dz = p[2] - meshlet.center[2];
+        radiusSq = std::max(radiusSq, dx * dx + dy * dy + dz * dz);
+    }
+    meshlet.radius = std::sqrt(radiusSq);
+
+    // Конус нормалей по геометрическим нормалям треугольников
+    std::vector<float> normals(meshlet.triangleCount * 3, 0.0f);
+    float axis[3] = {0.0f, 0.0f, 0.0f};
+    for (unsigned int t = 0; t < meshlet.triangleCount; t++) {
+        const float* p0 = vertices[indices[t * 3]].position;
+        const float* p1 = vertices[indices[t * 3 + 1]].position;
+        const float* p2 = vertices[indices[t * 3 + 2]].position;
+
+        float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+        float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length <= 0.0f) continue;
+
+        for (int k = 0; k < 3; k++) {
+            normals[t * 3 + k] = n[k] / length;
+            axis[k] += normals[t * 3 + k];
+        }
+    }
+
+    float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    meshlet.coneCutoff = 1.0f;
+    for (int k = 0; k < 3; k++) meshlet.coneAxis[k] = axisLength > 0.0f ? axis[k] / axisLength : 0.0f;
+    if (axisLength <= 0.0f) return;
+
+    float minDot = 1.0f;
+    for (unsigned int t = 0; t < meshlet.triangleCount; t++) {
+        const float* n = &normals[t * 3];
+        if (n[0] == 0.0f && n[1] == 0.0f && n[2] == 0.0f) continue;
+        minDot = std::min(minDot, n[0] * meshlet.coneAxis[0] + n[1] * meshlet.coneAxis[1] + n[2] * meshlet.coneAxis[2]);
+    }
+
+    // Разброс нормалей больше 90 градусов - кластер по конусу не отсекается
+    if (minDot > 0.0f) {
+        meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+    }
+}
+
+bool MeshletBuilder::isVisible(const Meshlet& meshlet, const Frustum& frustum, const float cameraPosition[3]) {
+    if (!frustum.intersectsSphere(meshlet.center, meshlet.radius)) return false;
+
+    if (meshlet.coneCutoff < 1.0f) {
+        float d[3] = {meshlet.center[0] - cameraPosition[0],
+                      meshlet.center[1] - cameraPosition[1],
+                      meshlet.center[2] - cameraPosition[2]};
+        float distance = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+        float along = d[0] * meshlet.coneAxis[0] + d[1] * meshlet.coneAxis[1] + d[2] * meshlet.coneAxis[2];
+        if (along >= meshlet.coneCutoff * distance + meshlet.radius) return false;
+    }
+    return true;
+}
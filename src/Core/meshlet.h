@@ -0,0 +1,26 @@
+#ifndef MESHLET_H
+#define MESHLET_H
+
+#include "parser.h"
+
+struct Frustum;
+
+// Разбиение меша на кластеры - непрерывные диапазоны индексов.
+// Треугольники после MeshOptimizer уже пространственно связны, поэтому
+// кластеры режутся по порядку без перестановки индексов.
+class MeshletBuilder {
+public:
+    static const unsigned int MAX_VERTICES = 64;
+    static const unsigned int MAX_TRIANGLES = 124;
+
+    static void build(StandardMesh& mesh, unsigned int maxVertices = MAX_VERTICES,
+                      unsigned int maxTriangles = MAX_TRIANGLES);
+
+    // cameraPosition - в пространстве модели
+    static bool isVisible(const Meshlet& meshlet, const Frustum& frustum, const float cameraPosition[3]);
+
+private:
+    static void computeBounds(Meshlet& meshlet, const StandardMesh& mesh);
+};
+
+#endif
@@ -0,0 +1,362 @@
+#include "meshopt.h"
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+static const unsigned int FORSYTH_CACHE_SIZE = 32;
+static const unsigned int FORSYTH_MAX_VALENCE = 32;
+
+struct VertexKeyHash {
+    size_t operator()(const StandardVertex& v) const {
+        // FNV-1a по байтам вершины
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&v);
+        size_t h = 2166136261u;
+        for (size_t i = 0; i < sizeof(StandardVertex); i++) {
+            h ^= bytes[i];
+            h *= 16777619u;
+        }
+        return h;
+    }
+};
+
+struct VertexKeyEqual {
+    bool operator()(const StandardVertex& a, const StandardVertex& b) const {
+        return std::memcmp(&a, &b, sizeof(StandardVertex)) == 0;
+    }
+};
+
+MeshOptimizationReport MeshOptimizer::optimize(StandardMesh& mesh) {
+    MeshOptimizationReport report = {};
+    report.verticesBefore = mesh.vertexCount();
+    report.before = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount());
+
+    if (mesh.indices.empty() || mesh.indices.size() % 3 != 0) {
+        report.verticesAfter = report.verticesBefore;
+        report.after = report.before;
+        return report;
+    }
+
+    // Вершины, отображённые из файла, не трогаем - переставляются только треугольники.
+    // Склейка сравнивает только StandardVertex и слила бы вершины с разными весами костей
+    bool ownsVertices = mesh.mappedVertices == nullptr;
+    if (ownsVertices && mesh.skin.empty()) weldVertices(mesh);
+    optimizeVertexCache(mesh.indices, mesh.vertexCount());
+    optimizeOverdraw(mesh.indices, mesh.vertexData(), mesh.vertexCount());
+    if (ownsVertices) optimizeVertexFetch(mesh);
+
+    report.verticesAfter = mesh.vertexCount();
+    report.after = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount());
+    return report;
+}
+
+size_t MeshOptimizer::weldVertices(StandardMesh& mesh) {
+    std::unordered_map<StandardVertex, unsigned int, VertexKeyHash, VertexKeyEqual> unique;
+    unique.reserve(mesh.vertices.size());
+
+    std::vector<unsigned int> remap(mesh.vertices.size());
+    std::vector<StandardVertex> welded;
+    welded.reserve(mesh.vertices.size());
+
+    for (size_t i = 0; i < mesh.vertices.size(); i++) {
+        auto result = unique.emplace(mesh.vertices[i], (unsigned int)welded.size());
+        if (result.second) {
+            welded.push_back(mesh.vertices[i]);
+        }
+        remap[i] = result.first->second;
+    }
+
+    size_t removed = mesh.vertices.size() - welded.size();
+    if (removed == 0) return 0;
+
+    for (auto& index : mesh.indices) {
+        index = remap[index];
+    }
+    welded.shrink_to_fit();
+    mesh.vertices.swap(welded);
+    return removed;
+}
+
+// Tom Forsyth, "Linear-Speed Vertex Cache Optimisation"
+static float cachePositionScore[FORSYTH_CACHE_SIZE];
+static float valenceScore[FORSYTH_MAX_VALENCE];
+
+static bool initForsythTables() {
+    for (unsigned int i = 0; i < FORSYTH_CACHE_SIZE; i++) {
+        if (i < 3) {
+            cachePositionScore[i] = 0.75f;
+        } else {
+            float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+            cachePositionScore[i] = std::pow(1.0f - (i - 3) * scaler, 1.5f);
+        }
+    }
+    for (unsigned int i = 0; i < FORSYTH_MAX_VALENCE; i++) {
+        valenceScore[i] = i == 0 ? 0.0f : 2.0f * std::pow((float)i, -0.5f);
+    }
+    return true;
+}
+
+static float forsythVertexScore(int cachePosition, unsigned int remaining) {
+    if (remaining == 0) return -1.0f;
+
+    float score = cachePosition >= 0 ? cachePositionScore[cachePosition] : 0.0f;
+    score += remaining < FORSYTH_MAX_VALENCE ? valenceScore[remaining] : 2.0f * std::pow((float)remaining, -0.5f);
+    return score;
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount) {
+    // Таблицы заполняются один раз; потоки пула могут вызвать это одновременно
+    static const bool tablesReady = initForsythTables();
+    (void)tablesReady;
+
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) return;
+
+    // Смежность вершина -> треугольники в CSR-виде
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (unsigned int index : indices) remaining[index]++;
+
+    std::vector<unsigned int> adjacencyOffset(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++) adjacencyOffset[v + 1] = adjacencyOffset[v] + remaining[v];
+
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = indices[t * 3 + k];
+            adjacency[fill[v]++] = (unsigned int)t;
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) vertexScore[v] = forsythVertexScore(-1, remaining[v]);
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<char> emitted(triangleCount, 0);
+    for (size_t t = 0; t < triangleCount; t++) {
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+    }
+
+    std::vector<unsigned int> cache;
+    std::vector<unsigned int> nextCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+
+    size_t scanCursor = 0;
+    long bestTriangle = -1;
+
+    for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+        if (bestTriangle < 0) {
+            // В кэше нет кандидатов - берём лучший из следующих непройденных
+            while (scanCursor < triangleCount && emitted[scanCursor]) scanCursor++;
+            bestTriangle = (long)scanCursor;
+            float bestScore = triangleScore[scanCursor];
+            for (size_t t = scanCursor + 1; t < triangleCount && t < scanCursor + 64; t++) {
+                if (!emitted[t] && triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    bestTriangle = (long)t;
+                }
+            }
+        }
+
+        size_t tri = (size_t)bestTriangle;
+        emitted[tri] = 1;
+        const unsigned int* triIndices = &indices[tri * 3];
+        result.insert(result.end(), triIndices, triIndices + 3);
+
+        // Убираем треугольник из смежности его вершин
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = triIndices[k];
+            unsigned int begin = adjacencyOffset[v];
+            unsigned int end = begin + remaining[v];
+            for (unsigned int a = begin; a < end; a++) {
+                if (adjacency[a] == tri) {
+                    adjacency[a] = adjacency[end - 1];
+                    break;
+                }
+            }
+            remaining[v]--;
+        }
+
+        nextCache.clear();
+        nextCache.insert(nextCache.end(), triIndices, triIndices + 3);
+        for (unsigned int v : cache) {
+            if (v != triIndices[0] && v != triIndices[1] && v != triIndices[2]) nextCache.push_back(v);
+        }
+
+        for (size_t i = 0; i < nextCache.size(); i++) {
+            unsigned int v = nextCache[i];
+            cachePosition[v] = i < FORSYTH_CACHE_SIZE ? (int)i : -1;
+            vertexScore[v] = forsythVertexScore(cachePosition[v], remaining[v]);
+        }
+
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+        for (unsigned int v : nextCache) {
+            unsigned int begin = adjacencyOffset[v];
+            unsigned int end = begin + remaining[v];
+            for (unsigned int a = begin; a < end; a++) {
+                unsigned int t = adjacency[a];
+                float score = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+                triangleScore[t] = score;
+                if (score > bestScore) {
+                    bestScore = score;
+                    bestTriangle = (long)t;
+                }
+            }
+        }
+
+        if (nextCache.size() > FORSYTH_CACHE_SIZE) nextCache.resize(FORSYTH_CACHE_SIZE);
+        cache.swap(nextCache);
+    }
+
+    indices.swap(result);
+}
+
+void MeshOptimizer::optimizeOverdraw(std::vector<unsigned int>& indices, const StandardVertex* vertices, size_t vertexCount) {
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2) return;
+
+    // Кластеры режем по жёстким границам: треугольник, все три вершины которого
+    // промахиваются мимо кэша, начинает новый кластер. Перестановка кластеров
+    // поэтому почти не портит попадания в кэш.
+    const unsigned int cacheSize = 16;
+    std::vector<unsigned int> timestamps(vertexCount, 0);
+    unsigned int time = cacheSize + 1;
+
+    std::vector<size_t> clusterStarts;
+    for (size_t t = 0; t < triangleCount; t++) {
+        int misses = 0;
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = indices[t * 3 + k];
+            if (time - timestamps[v] > cacheSize) {
+                timestamps[v] = time++;
+                misses++;
+            }
+        }
+        if (t == 0 || misses == 3) clusterStarts.push_back(t);
+    }
+    if (clusterStarts.size() < 2) return;
+    clusterStarts.push_back(triangleCount);
+
+    float meshCentroid[3] = {0.0f, 0.0f, 0.0f};
+    float meshArea = 0.0f;
+
+    size_t clusterCount = clusterStarts.size() - 1;
+    std::vector<float> clusterData(clusterCount * 6, 0.0f); // centroid(3) + normal(3)
+
+    for (size_t c = 0; c < clusterCount; c++) {
+        float* centroid = &clusterData[c * 6];
+        float* normal = &clusterData[c * 6 + 3];
+        float area = 0.0f;
+
+        for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++) {
+            const float* p0 = vertices[indices[t * 3]].position;
+            const float* p1 = vertices[indices[t * 3 + 1]].position;
+            const float* p2 = vertices[indices[t * 3 + 2]].position;
+
+            float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+            float triArea = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+            for (int k = 0; k < 3; k++) {
+                centroid[k] += (p0[k] + p1[k] + p2[k]) * (triArea / 3.0f);
+                normal[k] += n[k];
+            }
+            area += triArea;
+        }
+
+        for (int k = 0; k < 3; k++) meshCentroid[k] += centroid[k];
+        meshArea += area;
+
+        float invArea = area > 0.0f ? 1.0f / area : 0.0f;
+        float normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        float invNormal = normalLength > 0.0f ? 1.0f / normalLength : 0.0f;
+        for (int k = 0; k < 3; k++) {
+            centroid[k] *= invArea;
+            normal[k] *= invNormal;
+        }
+    }
+
+    float invMeshArea = meshArea > 0.0f ? 1.0f / meshArea : 0.0f;
+    for (int k = 0; k < 3; k++) meshCentroid[k] *= invMeshArea;
+
+    // Кластеры, смотрящие наружу от центра, рисуем первыми - они закрывают остальные
+    std::vector<float> sortKey(clusterCount);
+    std::vector<unsigned int> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++) {
+        const float* centroid = &clusterData[c * 6];
+        const float* normal = &clusterData[c * 6 + 3];
+        sortKey[c] = (centroid[0] - meshCentroid[0]) * normal[0] +
+                     (centroid[1] - meshCentroid[1]) * normal[1] +
+                     (centroid[2] - meshCentroid[2]) * normal[2];
+        order[c] = (unsigned int)c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&sortKey](unsigned int a, unsigned int b) {
+        return sortKey[a] > sortKey[b];
+    });
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (unsigned int c : order) {
+        result.insert(result.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+    }
+    indices.swap(result);
+}
+
+void MeshOptimizer::optimizeVertexFetch(StandardMesh& mesh) {
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> remap(mesh.vertices.size(), unused);
+    std::vector<StandardVertex> reordered;
+    reordered.reserve(mesh.vertices.size());
+    std::vector<VertexSkin> reorderedSkin;
+    reorderedSkin.reserve(mesh.skin.size());
+
+    // Вершины в порядке первого использования; неиспользуемые отбрасываются
+    for (auto& index : mesh.indices) {
+        if (remap[index] == unused) {
+            remap[index] = (unsigned int)reordered.size();
+            reordered.push_back(mesh.vertices[index]);
+            if (!mesh.skin.empty()) reorderedSkin.push_back(mesh.skin[index]);
+        }
+        index = remap[index];
+    }
+
+    reordered.shrink_to_fit();
+    mesh.vertices.swap(reordered);
+    mesh.skin.swap(reorderedSkin);
+}
+
+VertexCacheStats MeshOptimizer::analyzeVertexCache(const unsigned int* indices, size_t indexCount,
+                                                   size_t vertexCount, unsigned int cacheSize) {
+    VertexCacheStats stats = {0.0f, 0.0f};
+    if (indexCount < 3 || vertexCount == 0) return stats;
+
+    // FIFO-кэш пост-трансформа
+    std::vector<unsigned int> timestamps(vertexCount, 0);
+    std::vector<char> used(vertexCount, 0);
+    unsigned int time = cacheSize + 1;
+    size_t misses = 0;
+    size_t uniqueVertices = 0;
+
+    for (size_t i = 0; i < indexCount; i++) {
+        unsigned int v = indices[i];
+        if (time - timestamps[v] > cacheSize) {
+            timestamps[v] = time++;
+            misses++;
+        }
+        if (!used[v]) {
+            used[v] = 1;
+            uniqueVertices++;
+        }
+    }
+
+    stats.acmr = (float)misses / (float)(indexCount / 3);
+    stats.atvr = uniqueVertices ? (float)misses / (float)uniqueVertices : 0.0f;
+    return stats;
+}
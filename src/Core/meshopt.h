@@ -0,0 +1,23 @@
+#ifndef MESHOPT_H
+#define MESHOPT_H
+
+#include <vector>
+#include <cstddef>
+#include "parser.h"
+
+// Оптимизация меша после импорта: склейка дубликатов, порядок треугольников
+// под кэш вершин (Forsyth) и overdraw, порядок вершин под выборку
+class MeshOptimizer {
+public:
+    static MeshOptimizationReport optimize(StandardMesh& mesh);
+
+    static size_t weldVertices(StandardMesh& mesh);
+    static void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount);
+    static void optimizeOverdraw(std::vector<unsigned int>& indices, const StandardVertex* vertices, size_t vertexCount);
+    static void optimizeVertexFetch(StandardMesh& mesh);
+
+    static VertexCacheStats analyzeVertexCache(const unsigned int* indices, size_t indexCount,
+                                               size_t vertexCount, unsigned int cacheSize = 16);
+};
+
+#endif
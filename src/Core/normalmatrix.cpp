@@ -0,0 +1,29 @@
+#include "normalmatrix.h"
+#include <cmath>
+
+// Относительный допуск ортогональности и равенства длин столбцов
+const float UNIFORM_SCALE_TOLERANCE = 1e-5f;
+
+glm::mat3 computeNormalMatrix(const glm::mat4& model) {
+    glm::vec3 c0(model[0]), c1(model[1]), c2(model[2]);
+    float lengthSq = glm::dot(c0, c0);
+    float tolerance = UNIFORM_SCALE_TOLERANCE * lengthSq;
+
+    // R * s: столбцы ортогональны и одной длины, (R * s)^-T = R / s = M / s²
+    if (std::fabs(glm::dot(c1, c1) - lengthSq) <= tolerance &&
+        std::fabs(glm::dot(c2, c2) - lengthSq) <= tolerance &&
+        std::fabs(glm::dot(c0, c1)) <= tolerance &&
+        std::fabs(glm::dot(c0, c2)) <= tolerance &&
+        std::fabs(glm::dot(c1, c2)) <= tolerance) {
+        if (lengthSq <= 0.0f) return glm::mat3(1.0f);
+        return glm::mat3(c0, c1, c2) * (1.0f / lengthSq);
+    }
+
+    // M^-T = cofactor(M) / det, столбцы кофакторов - произведения пар столбцов M
+    glm::vec3 r0 = glm::cross(c1, c2);
+    glm::vec3 r1 = glm::cross(c2, c0);
+    glm::vec3 r2 = glm::cross(c0, c1);
+    float determinant = glm::dot(c0, r0);
+    if (std::fabs(determinant) <= 1e-30f) return glm::mat3(1.0f);
+    return glm::mat3(r0, r1, r2) * (1.0f / determinant);
+}
@@ -0,0 +1,17 @@
+#ifndef NORMALMATRIX_H
+#define NORMALMATRIX_H
+
+#include <glm/glm.hpp>
+
+// Матрица нормалей - обратная транспонированная к верхнему 3x3 мировой матрицы.
+// Считается на CPU раз на объект вместо inverse() на каждую вершину в шейдере.
+// Поворот с равномерным масштабом обходится без обращения; общий аффинный случай -
+// кофакторы 3x3 через векторные произведения. Вырожденная матрица даёт единичную.
+glm::mat3 computeNormalMatrix(const glm::mat4& model);
+
+// mat3 в std140/std430 и в атрибутах экземпляра - три столбца vec4
+inline glm::mat3x4 packNormalMatrix(const glm::mat3& normal) {
+    return glm::mat3x4(glm::vec4(normal[0], 0.0f), glm::vec4(normal[1], 0.0f), glm::vec4(normal[2], 0.0f));
+}
+
+#endif
@@ -0,0 +1,539 @@
+#include "objloader.h"
+#include "mappedfile.h"
+#include "threadpool.h"
+#include <cstring>
+#include <cmath>
+#include <cstdint>
+#include <atomic>
+#include <algorithm>
+#include <unordered_map>
+
+static const int64_t NO_INDEX = -1;
+// Отрицательные (относительные) индексы известны только относительно начала куска:
+// храним их со смещением и переводим в глобальные после подсчёта префиксных сумм
+static const int64_t RELATIVE_INDEX = (int64_t)1 << 40;
+static const size_t MIN_CHUNK_BYTES = 1 << 20;
+
+struct ObjCorner {
+    int64_t v;
+    int64_t vt;
+    int64_t vn;
+};
+
+// Грань больше треугольника: её веер в triangles[material] начиная с firstCorner
+struct ObjPolygon {
+    size_t material;
+    size_t firstCorner;
+    size_t cornerCount;
+};
+
+struct ObjChunk {
+    const char* begin;
+    const char* end;
+    std::vector<float> positions;
+    std::vector<float> texCoords;
+    std::vector<float> normals;
+    // Материал 0 - тот, что был активен в конце предыдущего куска
+    std::vector<std::string> materials;
+    std::vector<std::vector<ObjCorner>> triangles;
+    std::vector<ObjPolygon> polygons;
+    // Первый объект/группа куска ("o имя" или "g имя"); второй другой - multipleGroups
+    std::string group;
+    bool hasGroup;
+    bool multipleGroups;
+    bool failed;
+};
+
+// Восемь ASCII-цифр за раз в 64-битном регистре (SWAR)
+static inline bool isEightDigits(uint64_t chunk) {
+    return ((chunk & 0xF0F0F0F0F0F0F0F0ULL) |
+            (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL;
+}
+
+static inline uint32_t parseEightDigits(uint64_t chunk) {
+    const uint64_t mask = 0x000000FF000000FFULL;
+    const uint64_t mul1 = 0x000F424000000064ULL; // 100 + (1000000 << 32)
+    const uint64_t mul2 = 0x0000271000000001ULL; // 1 + (10000 << 32)
+    chunk -= 0x3030303030303030ULL;
+    chunk = (chunk * 10) + (chunk >> 8);
+    chunk = (((chunk & mask) * mul1) + (((chunk >> 16) & mask) * mul2)) >> 32;
+    return (uint32_t)chunk;
+}
+
+static inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* skipBlanks(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    return p;
+}
+
+// Цифры в мантиссу: не больше 19 значащих, остальные только сдвигают порядок
+static const char* readDigits(const char* p, const char* end, uint64_t& mantissa, int& digits,
+                              int& exponent, bool fraction, bool& any) {
+    while (p + 8 <= end && digits + 8 <= 19) {
+        uint64_t chunk;
+        std::memcpy(&chunk, p, sizeof(chunk));
+        if (!isEightDigits(chunk)) break;
+        mantissa = mantissa * 100000000ULL + parseEightDigits(chunk);
+        if (mantissa != 0) digits += 8;
+        if (fraction) exponent -= 8;
+        p += 8;
+        any = true;
+    }
+    while (p < end && isDigit(*p)) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            if (mantissa != 0) digits++;
+            if (fraction) exponent--;
+        } else if (!fraction) {
+            exponent++;
+        }
+        p++;
+        any = true;
+    }
+    return p;
+}
+
+const char* ObjLoader::parseFloat(const char* p, const char* end, float& value) {
+    static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any = false;
+    p = readDigits(p, end, mantissa, digits, exponent, false, any);
+    if (p < end && *p == '.') {
+        p = readDigits(p + 1, end, mantissa, digits, exponent, true, any);
+    }
+    if (!any) return nullptr;
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negativeExponent = *p == '-';
+            p++;
+        }
+        if (p >= end || !isDigit(*p)) return nullptr;
+        int e = 0;
+        while (p < end && isDigit(*p)) {
+            if (e < 10000) e = e * 10 + (*p - '0');
+            p++;
+        }
+        exponent += negativeExponent ? -e : e;
+    }
+
+    double result = (double)mantissa;
+    if (exponent < 0) {
+        result = exponent >= -22 ? result / powers[-exponent] : result * std::pow(10.0, exponent);
+    } else if (exponent > 0) {
+        result = exponent <= 22 ? result * powers[exponent] : result * std::pow(10.0, exponent);
+    }
+    value = (float)(negative ? -result : result);
+    return p;
+}
+
+// Число, за которым идёт пробел или конец строки
+static const char* readFloat(const char* p, const char* end, float& value) {
+    p = ObjLoader::parseFloat(skipBlanks(p, end), end, value);
+    if (p && p < end && !isBlank(*p)) return nullptr;
+    return p;
+}
+
+static const char* readIndex(const char* p, const char* end, int64_t& value) {
+    bool negative = p < end && *p == '-';
+    if (negative) p++;
+    if (p >= end || !isDigit(*p)) return nullptr;
+
+    int64_t result = 0;
+    while (p < end && isDigit(*p)) {
+        result = result * 10 + (*p - '0');
+        if (result > RELATIVE_INDEX / 4) return nullptr;
+        p++;
+    }
+    value = negative ? -result : result;
+    return p;
+}
+
+// 1-based или отрицательный индекс OBJ -> глобальный 0-based или относительный к началу куска
+static bool resolveIndex(int64_t raw, size_t localCount, int64_t& out) {
+    if (raw > 0) {
+        out = raw - 1;
+        return true;
+    }
+    if (raw < 0) {
+        out = RELATIVE_INDEX + (int64_t)localCount + raw;
+        return true;
+    }
+    return false;
+}
+
+static bool keywordIs(const char* p, const char* end, const char* keyword) {
+    size_t length = std::strlen(keyword);
+    return (size_t)(end - p) == length && std::memcmp(p, keyword, length) == 0;
+}
+
+static void parseChunk(ObjChunk& chunk) {
+    chunk.failed = true;
+    chunk.hasGroup = false;
+    chunk.multipleGroups = false;
+    chunk.materials.assign(1, std::string());
+    chunk.triangles.assign(1, std::vector<ObjCorner>());
+    size_t material = 0;
+    std::vector<ObjCorner> polygon;
+
+    const char* p = chunk.begin;
+    while (p < chunk.end) {
+        const char* newline = static_cast<const char*>(std::memchr(p, '\n', chunk.end - p));
+        const char* eol = newline ? newline : chunk.end;
+        const char* next = newline ? newline + 1 : chunk.end;
+
+        p = skipBlanks(p, eol);
+        const char* keyword = p;
+        while (p < eol && !isBlank(*p)) p++;
+        const char* keywordEnd = p;
+
+        if (keyword == keywordEnd || *keyword == '#') {
+            // пустая строка или комментарий
+        } else if (keywordIs(keyword, keywordEnd, "v")) {
+            float xyz[3];
+            for (int k = 0; k < 3; k++) {
+                if (!(p = readFloat(p, eol, xyz[k]))) return;
+            }
+            // Однородная w и цвета вершин игнорируются
+            chunk.positions.insert(chunk.positions.end(), xyz, xyz + 3);
+        } else if (keywordIs(keyword, keywordEnd, "vn")) {
+            float xyz[3];
+            for (int k = 0; k < 3; k++) {
+                if (!(p = readFloat(p, eol, xyz[k]))) return;
+            }
+            chunk.normals.insert(chunk.normals.end(), xyz, xyz + 3);
+        } else if (keywordIs(keyword, keywordEnd, "vt")) {
+            float uv[2] = {0.0f, 0.0f};
+            if (!(p = readFloat(p, eol, uv[0]))) return;
+            if (skipBlanks(p, eol) < eol && *skipBlanks(p, eol) != '\r') {
+                if (!(p = readFloat(p, eol, uv[1]))) return;
+            }
+            chunk.texCoords.insert(chunk.texCoords.end(), uv, uv + 2);
+        } else if (keywordIs(keyword, keywordEnd, "f")) {
+            polygon.clear();
+            while (true) {
+                p = skipBlanks(p, eol);
+                if (p >= eol || *p == '\r') break;
+
+                ObjCorner corner = {NO_INDEX, NO_INDEX, NO_INDEX};
+                int64_t raw;
+                if (!(p = readIndex(p, eol, raw)) || !resolveIndex(raw, chunk.positions.size() / 3, corner.v)) return;
+                if (p < eol && *p == '/') {
+                    p++;
+                    if (p < eol && *p != '/') {
+                        if (!(p = readIndex(p, eol, raw)) || !resolveIndex(raw, chunk.texCoords.size() / 2, corner.vt)) return;
+                    }
+                    if (p < eol && *p == '/') {
+                        p++;
+                        if (!(p = readIndex(p, eol, raw)) || !resolveIndex(raw, chunk.normals.size() / 3, corner.vn)) return;
+                    }
+                }
+                if (p < eol && !isBlank(*p)) return;
+                polygon.push_back(corner);
+            }
+            if (polygon.size() < 3) return;
+
+            // Многоугольник - веером; выпуклость проверяется, когда известны все позиции
+            std::vector<ObjCorner>& triangles = chunk.triangles[material];
+            if (polygon.size() > 3) {
+                ObjPolygon face = {material, triangles.size(), polygon.size()};
+                chunk.polygons.push_back(face);
+            }
+            for (size_t i = 1; i + 1 < polygon.size(); i++) {
+                triangles.push_back(polygon[0]);
+                triangles.push_back(polygon[i]);
+                triangles.push_back(polygon[i + 1]);
+            }
+        } else if (keywordIs(keyword, keywordEnd, "usemtl")) {
+            const char* nameBegin = skipBlanks(p, eol);
+            const char* nameEnd = eol;
+            while (nameEnd > nameBegin && isBlank(nameEnd[-1])) nameEnd--;
+            chunk.materials.push_back(std::string(nameBegin, nameEnd));
+            chunk.triangles.push_back(std::vector<ObjCorner>());
+            material = chunk.materials.size() - 1;
+        } else if (keywordIs(keyword, keywordEnd, "o") || keywordIs(keyword, keywordEnd, "g")) {
+            // Assimp делит меши ещё и по объектам и строит для них узлы; здесь меши только
+            // по материалам, поэтому файл с несколькими объектами отдаётся Assimp
+            const char* nameEnd = eol;
+            while (nameEnd > p && isBlank(nameEnd[-1])) nameEnd--;
+            std::string group = std::string(keyword, keywordEnd) + " " + std::string(skipBlanks(p, eol), nameEnd);
+            if (!chunk.hasGroup) {
+                chunk.group = group;
+                chunk.hasGroup = true;
+            } else if (group != chunk.group) {
+                chunk.multipleGroups = true;
+            }
+        } else if (keywordIs(keyword, keywordEnd, "s") || keywordIs(keyword, keywordEnd, "mtllib")) {
+            // Сглаживание задают нормали файла; свойства MTL рендерер не использует
+        } else {
+            // Линии, точки, кривые и поверхности - пусть разбирает Assimp
+            return;
+        }
+        p = next;
+    }
+    chunk.failed = false;
+}
+
+static inline int64_t toGlobal(int64_t index, size_t chunkOffset) {
+    if (index == NO_INDEX) return NO_INDEX;
+    return index >= RELATIVE_INDEX / 2 ? (int64_t)chunkOffset + (index - RELATIVE_INDEX) : index;
+}
+
+// Выпуклость в плоскости грани (нормаль Ньюэлла): все повороты в одну сторону
+// и один полный оборот - звёздчатые грани тоже не выпуклые
+static bool isConvexPolygon(const std::vector<const float*>& points) {
+    size_t n = points.size();
+    double normal[3] = {0.0, 0.0, 0.0};
+    for (size_t i = 0; i < n; i++) {
+        const float* a = points[i];
+        const float* b = points[(i + 1) % n];
+        normal[0] += ((double)a[1] - b[1]) * ((double)a[2] + b[2]);
+        normal[1] += ((double)a[2] - b[2]) * ((double)a[0] + b[0]);
+        normal[2] += ((double)a[0] - b[0]) * ((double)a[1] + b[1]);
+    }
+    double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+    // Вырожденная грань: веер даёт такие же пустые треугольники
+    if (length == 0.0) return true;
+
+    double turning = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        const float* prev = points[(i + n - 1) % n];
+        const float* cur = points[i];
+        const float* next = points[(i + 1) % n];
+        double e1[3], e2[3];
+        for (int k = 0; k < 3; k++) {
+            e1[k] = (double)cur[k] - prev[k];
+            e2[k] = (double)next[k] - cur[k];
+        }
+        double cross[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+        double sine = (cross[0] * normal[0] + cross[1] * normal[1] + cross[2] * normal[2]) / length;
+        double cosine = e1[0] * e2[0] + e1[1] * e2[1] + e1[2] * e2[2];
+        double scale = std::sqrt((e1[0] * e1[0] + e1[1] * e1[1] + e1[2] * e1[2]) * (e2[0] * e2[0] + e2[1] * e2[1] + e2[2] * e2[2]));
+        if (sine < -1e-6 * scale) return false;
+        turning += std::atan2(sine, cosine);
+    }
+    // Выпуклая грань поворачивается ровно на 2π, звезда - на 4π и больше
+    return turning < 3.0 * 3.14159265358979;
+}
+
+bool ObjLoader::isObjFile(const std::string& path) {
+    if (path.size() < 4) return false;
+    std::string extension = path.substr(path.size() - 4);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == ".obj";
+}
+
+bool ObjLoader::load(const std::string& path, std::vector<StandardMesh>& meshes, std::vector<char>& missingNormals) {
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    const char* data = reinterpret_cast<const char*>(file.data());
+    const char* end = data + file.size();
+
+    // Переводы строк только через \r (старый Mac) не поддерживаем
+    size_t probe = std::min(file.size(), (size_t)65536);
+    for (size_t i = 0; i + 1 < probe; i++) {
+        if (data[i] == '\r' && data[i + 1] != '\n') return false;
+    }
+
+    ThreadPool& pool = ThreadPool::shared();
+    size_t chunkCount = std::max((size_t)1, std::min(file.size() / MIN_CHUNK_BYTES, (pool.getThreadCount() + 1) * 4));
+
+    std::vector<ObjChunk> chunks(chunkCount);
+    const char* chunkBegin = data;
+    for (size_t i = 0; i < chunkCount; i++) {
+        const char* chunkEnd = end;
+        if (i + 1 < chunkCount) {
+            const char* split = std::max(chunkBegin, data + file.size() * (i + 1) / chunkCount);
+            const char* newline = static_cast<const char*>(std::memchr(split, '\n', end - split));
+            chunkEnd = newline ? newline + 1 : end;
+        }
+        chunks[i].begin = chunkBegin;
+        chunks[i].end = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+
+    pool.parallelFor(chunkCount, [&](size_t i) {
+        parseChunk(chunks[i]);
+    });
+
+    // Префиксные суммы атрибутов и материалы в порядке первого появления
+    std::vector<size_t> positionOffset(chunkCount), texCoordOffset(chunkCount), normalOffset(chunkCount);
+    size_t positionCount = 0, texCoordCount = 0, normalCount = 0;
+    std::unordered_map<std::string, size_t> materialIds;
+    std::vector<std::vector<size_t>> chunkMaterials(chunkCount);
+    size_t inherited = 0;
+    materialIds[std::string()] = 0;
+
+    const std::string* group = nullptr;
+    for (size_t i = 0; i < chunkCount; i++) {
+        ObjChunk& chunk = chunks[i];
+        if (chunk.failed || chunk.multipleGroups) return false;
+        if (chunk.hasGroup) {
+            if (group && *group != chunk.group) return false;
+            group = &chunk.group;
+        }
+
+        positionOffset[i] = positionCount;
+        texCoordOffset[i] = texCoordCount;
+        normalOffset[i] = normalCount;
+        positionCount += chunk.positions.size() / 3;
+        texCoordCount += chunk.texCoords.size() / 2;
+        normalCount += chunk.normals.size() / 3;
+
+        chunkMaterials[i].resize(chunk.materials.size());
+        chunkMaterials[i][0] = inherited;
+        for (size_t m = 1; m < chunk.materials.size(); m++) {
+            size_t id = materialIds.emplace(chunk.materials[m], materialIds.size()).first->second;
+            chunkMaterials[i][m] = id;
+        }
+        inherited = chunkMaterials[i].back();
+    }
+
+    std::vector<float> positions(positionCount * 3), texCoords(texCoordCount * 2), normals(normalCount * 3);
+    pool.parallelFor(chunkCount, [&](size_t i) {
+        std::copy(chunks[i].positions.begin(), chunks[i].positions.end(), positions.begin() + positionOffset[i] * 3);
+        std::copy(chunks[i].texCoords.begin(), chunks[i].texCoords.end(), texCoords.begin() + texCoordOffset[i] * 2);
+        std::copy(chunks[i].normals.begin(), chunks[i].normals.end(), normals.begin() + normalOffset[i] * 3);
+        std::vector<float>().swap(chunks[i].positions);
+        std::vector<float>().swap(chunks[i].texCoords);
+        std::vector<float>().swap(chunks[i].normals);
+    });
+
+    // Веер верен только для выпуклых граней; вогнутые Assimp режет отсечением ушей -
+    // такой файл целиком отдаём ему
+    std::atomic<bool> concave(false);
+    pool.parallelFor(chunkCount, [&](size_t i) {
+        std::vector<const float*> points;
+        for (const ObjPolygon& polygon : chunks[i].polygons) {
+            if (concave) return;
+            const std::vector<ObjCorner>& corners = chunks[i].triangles[polygon.material];
+            points.clear();
+            for (size_t j = 0; j < polygon.cornerCount; j++) {
+                // Углы веера: 0, 1, затем третий угол каждого треугольника
+                size_t c = polygon.firstCorner + (j < 2 ? j : 3 * (j - 2) + 2);
+                int64_t v = toGlobal(corners[c].v, positionOffset[i]);
+                // Индекс вне файла - сообщит сборка мешей ниже
+                if (v < 0 || v >= (int64_t)positionCount) break;
+                points.push_back(&positions[v * 3]);
+            }
+            if (points.size() == polygon.cornerCount && !isConvexPolygon(points)) concave = true;
+        }
+    });
+    if (concave) return false;
+
+    // Куда каждый кусок пишет углы каждого материала
+    size_t materialCount = materialIds.size();
+    std::vector<size_t> cornerCount(materialCount, 0);
+    std::vector<std::vector<size_t>> cornerOffset(chunkCount);
+    for (size_t i = 0; i < chunkCount; i++) {
+        cornerOffset[i].resize(chunks[i].triangles.size());
+        for (size_t m = 0; m < chunks[i].triangles.size(); m++) {
+            size_t id = chunkMaterials[i][m];
+            cornerOffset[i][m] = cornerCount[id];
+            cornerCount[id] += chunks[i].triangles[m].size();
+        }
+    }
+
+    std::vector<int> meshOfMaterial(materialCount, -1);
+    std::vector<StandardMesh> loaded;
+    for (size_t id = 0; id < materialCount; id++) {
+        if (cornerCount[id] == 0) continue;
+        meshOfMaterial[id] = (int)loaded.size();
+        loaded.push_back(StandardMesh());
+        loaded.back().vertices.resize(cornerCount[id]);
+        loaded.back().indices.resize(cornerCount[id]);
+    }
+
+    std::atomic<bool> outOfRange(false);
+    pool.parallelFor(chunkCount, [&](size_t i) {
+        ObjChunk& chunk = chunks[i];
+        for (size_t m = 0; m < chunk.triangles.size(); m++) {
+            const std::vector<ObjCorner>& corners = chunk.triangles[m];
+            if (corners.empty()) continue;
+
+            StandardMesh& mesh = loaded[meshOfMaterial[chunkMaterials[i][m]]];
+            size_t base = cornerOffset[i][m];
+
+            for (size_t c = 0; c < corners.size(); c += 3) {
+                StandardVertex* triangle = &mesh.vertices[base + c];
+                bool needsFaceNormal = false;
+
+                for (int k = 0; k < 3; k++) {
+                    const ObjCorner& corner = corners[c + k];
+                    StandardVertex& vertex = triangle[k];
+                    int64_t v = toGlobal(corner.v, positionOffset[i]);
+                    int64_t vt = toGlobal(corner.vt, texCoordOffset[i]);
+                    int64_t vn = toGlobal(corner.vn, normalOffset[i]);
+                    if (v < 0 || v >= (int64_t)positionCount || vt >= (int64_t)texCoordCount ||
+                        vn >= (int64_t)normalCount || (corner.vt != NO_INDEX && vt < 0) || (corner.vn != NO_INDEX && vn < 0)) {
+                        outOfRange = true;
+                        return;
+                    }
+
+                    std::memcpy(vertex.position, &positions[v * 3], sizeof(vertex.position));
+                    if (vt >= 0) {
+                        vertex.texCoords[0] = texCoords[vt * 2];
+                        vertex.texCoords[1] = 1.0f - texCoords[vt * 2 + 1];
+                    } else {
+                        vertex.texCoords[0] = 0.0f;
+                        vertex.texCoords[1] = 0.0f;
+                    }
+                    if (vn >= 0) {
+                        std::memcpy(vertex.normal, &normals[vn * 3], sizeof(vertex.normal));
+                    } else {
+                        // Без нормалей в файле их сглаживает парсер - нормаль грани не нужна
+                        needsFaceNormal = normalCount > 0;
+                    }
+                    mesh.indices[base + c + k] = (unsigned int)(base + c + k);
+                }
+
+                if (needsFaceNormal) {
+                    const float* p0 = triangle[0].position;
+                    const float* p1 = triangle[1].position;
+                    const float* p2 = triangle[2].position;
+                    float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+                    float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+                    float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+                    float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                    if (length > 0.0f) {
+                        n[0] /= length; n[1] /= length; n[2] /= length;
+                    } else {
+                        n[0] = 0.0f; n[1] = 1.0f; n[2] = 0.0f;
+                    }
+                    for (int k = 0; k < 3; k++) {
+                        if (toGlobal(corners[c + k].vn, normalOffset[i]) < 0) {
+                            std::memcpy(triangle[k].normal, n, sizeof(n));
+                        }
+                    }
+                }
+            }
+        }
+    });
+
+    if (outOfRange || loaded.empty()) return false;
+    meshes.swap(loaded);
+    missingNormals.assign(meshes.size(), normalCount == 0 ? 1 : 0);
+    return true;
+}
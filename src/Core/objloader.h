@@ -0,0 +1,31 @@
+#ifndef OBJLOADER_H
+#define OBJLOADER_H
+
+#include <string>
+#include <vector>
+#include "parser.h"
+
+// Собственный загрузчик Wavefront OBJ: файл отображается в память, режется на
+// куски по границам строк и разбирается параллельно, меши собираются сразу
+// в StandardMesh - по одному на материал (usemtl). Assimp делит меши ещё и по
+// объектам (o, g), поэтому загрузчик берёт только файлы с одним объектом или группой -
+// для них меши те же, что у Assimp, а узлы сведены в один корневой.
+// Вершины совпадают с Assimp при Triangulate | FlipUVs: вершина на каждый угол,
+// v текстуры перевёрнута. Углы без vn в файле с нормалями получают нормаль грани;
+// если нормалей в файле нет совсем, меш помечается в missingNormals.
+// Многоугольники режутся веером - это верно только для выпуклых граней, поэтому
+// файл с вогнутой гранью отдаётся Assimp (он режет такие отсечением ушей).
+class ObjLoader {
+public:
+    static bool isObjFile(const std::string& path);
+
+    // false - в файле есть то, что загрузчик не поддерживает (кривые, линии,
+    // точки, переносы строк, вогнутые грани, несколько объектов или групп),
+    // или он повреждён: вызывающий уходит на Assimp
+    static bool load(const std::string& path, std::vector<StandardMesh>& meshes, std::vector<char>& missingNormals);
+
+    // Разбор десятичного числа с плавающей точкой; nullptr при ошибке
+    static const char* parseFloat(const char* p, const char* end, float& value);
+};
+
+#endif
@@ -1,43 +1,542 @@
 #include "parser.h"
+#include "meshbinary.h"
+#include "threadpool.h"
+#include "memstats.h"
+#include "meshopt.h"
+#include "meshlet.h"
+#include "simplify.h"
+#include "importprofile.h"
+#include "objloader.h"
+#include "glbloader.h"
+#include "tangentspace.h"
+#include "bounds.h"
 #include <iostream>
+#include <chrono>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <algorithm>
+#include <unordered_map>
+#include <cmath>
+#include <cstring>
 
-ModelParser::ModelParser() {}
+static double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// aiMatrix4x4 хранится по строкам, glm - по столбцам
+static glm::mat4 toGlm(const aiMatrix4x4& m) {
+    return glm::mat4(m.a1, m.b1, m.c1, m.d1,
+                     m.a2, m.b2, m.c2, m.d2,
+                     m.a3, m.b3, m.c3, m.d3,
+                     m.a4, m.b4, m.c4, m.d4);
+}
+
+// Хэш исходных данных меша Assimp: совпадает у копий одной геометрии под разными индексами
+static uint64_t hashSourceMesh(const aiMesh* mesh) {
+    uint32_t counts[4] = {mesh->mNumVertices, mesh->mNumFaces, mesh->mMaterialIndex,
+                          (uint32_t)(mesh->mNormals != nullptr) | (uint32_t)(mesh->mTextureCoords[0] != nullptr) << 1};
+    uint64_t hash = MeshBinaryCache::hashBytes(counts, sizeof(counts));
+    hash = MeshBinaryCache::hashBytes(mesh->mVertices, mesh->mNumVertices * sizeof(aiVector3D), hash);
+    if (mesh->mNormals) {
+        hash = MeshBinaryCache::hashBytes(mesh->mNormals, mesh->mNumVertices * sizeof(aiVector3D), hash);
+    }
+    if (mesh->mTextureCoords[0]) {
+        hash = MeshBinaryCache::hashBytes(mesh->mTextureCoords[0], mesh->mNumVertices * sizeof(aiVector3D), hash);
+    }
+    for (unsigned int f = 0; f < mesh->mNumFaces; f++) {
+        const aiFace& face = mesh->mFaces[f];
+        hash = MeshBinaryCache::hashBytes(face.mIndices, face.mNumIndices * sizeof(unsigned int), hash);
+    }
+    // Одна геометрия с разными костями - разные меши
+    for (unsigned int b = 0; b < mesh->mNumBones; b++) {
+        const aiBone* bone = mesh->mBones[b];
+        hash = MeshBinaryCache::hashBytes(bone->mName.C_Str(), bone->mName.length, hash);
+        hash = MeshBinaryCache::hashBytes(&bone->mOffsetMatrix, sizeof(aiMatrix4x4), hash);
+        hash = MeshBinaryCache::hashBytes(bone->mWeights, bone->mNumWeights * sizeof(aiVertexWeight), hash);
+    }
+    return hash;
+}
+
+// Побайтное сравнение всего, что входит в hashSourceMesh - совпадение хэша ещё не равенство
+static bool sameSourceMesh(const aiMesh* a, const aiMesh* b) {
+    if (a->mNumVertices != b->mNumVertices || a->mNumFaces != b->mNumFaces ||
+        a->mMaterialIndex != b->mMaterialIndex || a->mNumBones != b->mNumBones ||
+        (a->mNormals != nullptr) != (b->mNormals != nullptr) ||
+        (a->mTextureCoords[0] != nullptr) != (b->mTextureCoords[0] != nullptr)) {
+        return false;
+    }
+    size_t vectorBytes = a->mNumVertices * sizeof(aiVector3D);
+    if (memcmp(a->mVertices, b->mVertices, vectorBytes) != 0) return false;
+    if (a->mNormals && memcmp(a->mNormals, b->mNormals, vectorBytes) != 0) return false;
+    if (a->mTextureCoords[0] && memcmp(a->mTextureCoords[0], b->mTextureCoords[0], vectorBytes) != 0) return false;
+    for (unsigned int f = 0; f < a->mNumFaces; f++) {
+        const aiFace& faceA = a->mFaces[f];
+        const aiFace& faceB = b->mFaces[f];
+        if (faceA.mNumIndices != faceB.mNumIndices ||
+            memcmp(faceA.mIndices, faceB.mIndices, faceA.mNumIndices * sizeof(unsigned int)) != 0) {
+            return false;
+        }
+    }
+    for (unsigned int i = 0; i < a->mNumBones; i++) {
+        const aiBone* boneA = a->mBones[i];
+        const aiBone* boneB = b->mBones[i];
+        if (boneA->mName != boneB->mName || boneA->mNumWeights != boneB->mNumWeights ||
+            memcmp(&boneA->mOffsetMatrix, &boneB->mOffsetMatrix, sizeof(aiMatrix4x4)) != 0 ||
+            memcmp(boneA->mWeights, boneB->mWeights, boneA->mNumWeights * sizeof(aiVertexWeight)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Веса костей: по вершине остаются четыре самых сильных влияния, нормированные к сумме 255.
+// Кости без узла привязываются к корню, их имена уходят в unbound - печатает вызывающий
+static void importBones(const aiMesh* source, const std::unordered_map<std::string, uint32_t>& nodes, StandardMesh& mesh,
+                        std::vector<std::string>& unbound) {
+    if (!source->HasBones()) return;
+
+    size_t vertexCount = source->mNumVertices;
+    std::vector<float> weights(vertexCount * MAX_BONE_INFLUENCES, 0.0f);
+    mesh.skin.assign(vertexCount, VertexSkin());
+    mesh.bones.resize(source->mNumBones);
+
+    for (unsigned int b = 0; b < source->mNumBones; b++) {
+        const aiBone* bone = source->mBones[b];
+        auto node = nodes.find(bone->mName.C_Str());
+        if (node == nodes.end()) {
+            unbound.push_back(bone->mName.C_Str());
+        }
+        mesh.bones[b].node = node != nodes.end() ? node->second : 0;
+        mesh.bones[b].offset = toGlm(bone->mOffsetMatrix);
+
+        for (unsigned int w = 0; w < bone->mNumWeights; w++) {
+            const aiVertexWeight& influence = bone->mWeights[w];
+            if (influence.mVertexId >= vertexCount) continue;
+
+            // Вытесняем самое слабое из уже записанных влияний
+            float* slots = &weights[influence.mVertexId * MAX_BONE_INFLUENCES];
+            unsigned int weakest = 0;
+            for (unsigned int k = 1; k < MAX_BONE_INFLUENCES; k++) {
+                if (slots[k] < slots[weakest]) weakest = k;
+            }
+            if (influence.mWeight > slots[weakest]) {
+                slots[weakest] = influence.mWeight;
+                mesh.skin[influence.mVertexId].bones[weakest] = (uint16_t)b;
+            }
+        }
+    }
+
+    for (size_t v = 0; v < vertexCount; v++) {
+        const float* slots = &weights[v * MAX_BONE_INFLUENCES];
+        float sum = slots[0] + slots[1] + slots[2] + slots[3];
+        if (sum <= 0.0f) continue; // вершина без весов остаётся в bind-позе
+
+        VertexSkin& skin = mesh.skin[v];
+        unsigned int total = 0, strongest = 0;
+        for (unsigned int k = 0; k < MAX_BONE_INFLUENCES; k++) {
+            skin.weights[k] = (uint8_t)std::lround(slots[k] / sum * 255.0f);
+            total += skin.weights[k];
+            if (slots[k] > slots[strongest]) strongest = k;
+        }
+        // Ошибку округления забирает самое сильное влияние
+        skin.weights[strongest] = (uint8_t)(skin.weights[strongest] + 255 - (int)total);
+    }
+}
+
+static void importAnimations(const aiScene* scene, const std::unordered_map<std::string, uint32_t>& nodes,
+                             std::vector<AnimationClip>& animations) {
+    animations.resize(scene->mNumAnimations);
+    RawAnimationClip clip;
+    for (unsigned int a = 0; a < scene->mNumAnimations; a++) {
+        const aiAnimation* source = scene->mAnimations[a];
+        double ticksPerSecond = source->mTicksPerSecond > 0.0 ? source->mTicksPerSecond : 25.0;
+        clip.name = source->mName.C_Str();
+        clip.duration = (float)(source->mDuration / ticksPerSecond);
+        clip.channels.clear();
+
+        for (unsigned int c = 0; c < source->mNumChannels; c++) {
+            const aiNodeAnim* track = source->mChannels[c];
+            auto node = nodes.find(track->mNodeName.C_Str());
+            if (node == nodes.end()) continue;
+
+            // Пустые дорожки получают значение из bind-позы узла
+            aiVector3D bindScale, bindPosition;
+            aiQuaternion bindRotation;
+            const aiNode* sourceNode = scene->mRootNode->FindNode(track->mNodeName);
+            if (sourceNode) sourceNode->mTransformation.Decompose(bindScale, bindRotation, bindPosition);
+
+            RawAnimationChannel channel;
+            channel.node = node->second;
+            for (unsigned int k = 0; k < track->mNumPositionKeys; k++) {
+                const aiVectorKey& key = track->mPositionKeys[k];
+                channel.positions.push_back(VectorKey{(float)(key.mTime / ticksPerSecond), glm::vec3(key.mValue.x, key.mValue.y, key.mValue.z)});
+            }
+            for (unsigned int k = 0; k < track->mNumRotationKeys; k++) {
+                const aiQuatKey& key = track->mRotationKeys[k];
+                channel.rotations.push_back(RotationKey{(float)(key.mTime / ticksPerSecond), glm::quat(key.mValue.w, key.mValue.x, key.mValue.y, key.mValue.z)});
+            }
+            for (unsigned int k = 0; k < track->mNumScalingKeys; k++) {
+                const aiVectorKey& key = track->mScalingKeys[k];
+                channel.scales.push_back(VectorKey{(float)(key.mTime / ticksPerSecond), glm::vec3(key.mValue.x, key.mValue.y, key.mValue.z)});
+            }
+            if (channel.positions.empty()) {
+                channel.positions.push_back(VectorKey{0.0f, glm::vec3(bindPosition.x, bindPosition.y, bindPosition.z)});
+            }
+            if (channel.rotations.empty()) {
+                channel.rotations.push_back(RotationKey{0.0f, glm::quat(bindRotation.w, bindRotation.x, bindRotation.y, bindRotation.z)});
+            }
+            if (channel.scales.empty()) {
+                channel.scales.push_back(VectorKey{0.0f, glm::vec3(bindScale.x, bindScale.y, bindScale.z)});
+            }
+            clip.channels.push_back(std::move(channel));
+        }
+        
+        // Сырые ключи живут только до сжатия
+        AnimationCompressor::compress(clip, AnimationCompression(), animations[a]);
+    }
+}
+
+ModelParser::ModelParser() : sceneBounds(), useBinaryCache(true), keepCpuCopies(true), optimizeMeshes(true), buildMeshlets(true), buildLods(true), useNativeLoaders(true), buildTangents(true), creaseAngle(60.0f), verbose(true), memoryReport() {}
 
 bool ModelParser::loadModel(const std::string& path) {
+    meshes.clear();
+    sceneGraph.clear();
+    sceneBounds = MeshBounds();
+    animations.clear();
+    meshTimings.clear();
+    missingNormals.clear();
+    optimizationReports.clear();
+    mappedCache.reset();
+    mappedSource.reset();
+    importProfile.reset(path);
+    directory = path.substr(0, path.find_last_of('/'));
+    
+    StageSample lookupSample;
+    uint64_t sourceHash = 0, sourceSize = 0;
+    bool hashed = useBinaryCache && MeshBinaryCache::hashFile(path, sourceHash, sourceSize);
+    std::string cachePath = MeshBinaryCache::getCachePath(path);
+    bool cached = hashed && MeshBinaryCache::load(cachePath, sourceHash, sourceSize, getCacheOptionsHash(),
+                                                  meshes, sceneGraph, sceneBounds, mappedCache);
+    importProfile.record(ImportStage::CACHE_LOOKUP, lookupSample, cached ? getCpuMeshBytes() : 0);
+    
+    if (cached) {
+        if (verbose) std::cout << "Loaded mesh cache: " << cachePath << std::endl;
+        sceneGraph.updateWorldTransforms();
+        memoryReport.cpuMeshBytes = getCpuMeshBytes();
+        memoryReport.peakRssBytes = getPeakRss();
+        memoryReport.currentRssBytes = getCurrentRss();
+        finishImportProfile(true);
+        if (meshReadyCallback) {
+            for (size_t i = 0; i < meshes.size(); i++) meshReadyCallback(i, meshes.size());
+        }
+        return true;
+    }
+    
+    // OBJ и GLB разбираются своими загрузчиками, всё остальное (и то, что они не осилили) - Assimp
+    bool imported = false;
+    if (useNativeLoaders && ObjLoader::isObjFile(path)) {
+        imported = importObj(path, sourceSize);
+    } else if (useNativeLoaders && GlbLoader::isGlbFile(path)) {
+        imported = importGlb(path, sourceSize);
+    }
+    if (!imported && !importAssimp(path, sourceSize)) {
+        return false;
+    }
+    BoundsBuilder::computeScene(meshes, sceneGraph, sceneBounds);
+    memoryReport.cpuMeshBytes = getCpuMeshBytes();
+    memoryReport.currentRssBytes = getCurrentRss();
+    
+    // Кэш не хранит кости и клипы - анимированные модели всегда импортируются заново
+    StageSample writeSample;
+    bool written = hashed && !isAnimated() &&
+                   MeshBinaryCache::save(cachePath, sourceHash, sourceSize, getCacheOptionsHash(), meshes, sceneGraph);
+    importProfile.record(ImportStage::CACHE_WRITE, writeSample, written ? getCpuMeshBytes() : 0);
+    if (verbose && written) {
+        std::cout << "Mesh cache written: " << cachePath << std::endl;
+    }
+    
+    if (verbose && optimizeMeshes) {
+        printOptimizationReport();
+    }
+    finishImportProfile(false);
+    return true;
+}
+
+uint64_t ModelParser::getCacheOptionsHash() const {
+    // По полю, без структуры - в хэш не попадает выравнивание
+    const bool flags[] = {optimizeMeshes, buildMeshlets, buildLods, buildTangents, useNativeLoaders};
+    uint64_t hash = MeshBinaryCache::hashBytes(flags, sizeof(flags));
+    return MeshBinaryCache::hashBytes(&creaseAngle, sizeof(creaseAngle), hash);
+}
+
+bool ModelParser::importObj(const std::string& path, uint64_t sourceSize) {
+    StageSample readSample;
+    bool parsed = ObjLoader::load(path, meshes, missingNormals);
+    if (!parsed) {
+        if (verbose) std::cout << "Native OBJ loader cannot handle " << path << ", falling back to Assimp" << std::endl;
+        meshes.clear();
+        missingNormals.clear();
+        return false;
+    }
+    importProfile.record(ImportStage::READ_FILE, readSample, sourceSize);
+    
+    // Иерархии в OBJ нет: один корневой узел, по экземпляру на каждый меш
+    StageSample graphSample;
+    uint32_t root = sceneGraph.addNode(SCENE_NO_PARENT, glm::mat4(1.0f), "root");
+    for (size_t i = 0; i < meshes.size(); i++) {
+        sceneGraph.addMeshInstance(root, (uint32_t)i);
+    }
+    sceneGraph.updateWorldTransforms();
+    importProfile.record(ImportStage::SCENE_GRAPH, graphSample);
+    
+    finishMeshes();
+    if (verbose) {
+        std::cout << "Parsed OBJ into " << meshes.size() << " meshes on " << ThreadPool::shared().getThreadCount() + 1
+                  << " threads in " << readSample.elapsedMs() << " ms" << std::endl;
+    }
+    memoryReport.peakRssBytes = getPeakRss();
+    return true;
+}
+
+bool ModelParser::importGlb(const std::string& path, uint64_t sourceSize) {
+    StageSample readSample;
+    size_t zeroCopyMeshes = 0;
+    if (!GlbLoader::load(path, meshes, sceneGraph, mappedSource, zeroCopyMeshes)) {
+        if (verbose) std::cout << "Native GLB loader cannot handle " << path << ", falling back to Assimp" << std::endl;
+        return false;
+    }
+    importProfile.record(ImportStage::READ_FILE, readSample, sourceSize);
+    
+    StageSample graphSample;
+    sceneGraph.updateWorldTransforms();
+    importProfile.record(ImportStage::SCENE_GRAPH, graphSample);
+    
+    finishMeshes();
+    if (verbose) {
+        std::cout << "Parsed GLB into " << meshes.size() << " meshes, " << zeroCopyMeshes
+                  << " reference the file directly" << std::endl;
+    }
+    memoryReport.peakRssBytes = getPeakRss();
+    return true;
+}
+
+// Меши, полученные собственными загрузчиками, уже сконвертированы - остаются общие стадии
+void ModelParser::finishMeshes() {
+    meshTimings.assign(meshes.size(), MeshTiming());
+    missingNormals.resize(meshes.size(), 0);
+    optimizationReports.resize(optimizeMeshes ? meshes.size() : 0);
+    importProfile.beginMeshStages(meshes.size());
+    
+    StageSample processSample;
+    ThreadPool::shared().parallelFor(meshes.size(), [&](size_t i) {
+        meshTimings[i].sourceMesh = (unsigned int)i;
+        finishMesh(i);
+    });
+    importProfile.record(ImportStage::PROCESS_MESHES, processSample);
+    importProfile.finishMeshStages();
+}
+
+bool ModelParser::importAssimp(const std::string& path, uint64_t sourceSize) {
+    // Разбор и постобработка замеряются отдельно
+    StageSample readSample;
     Assimp::Importer import;
-    const aiScene* scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals);
+    const aiScene* scene = import.ReadFile(path, 0);
+    importProfile.record(ImportStage::READ_FILE, readSample, sourceSize);
+    
+    if (scene) {
+        StageSample postSample;
+        scene = import.ApplyPostProcessing(aiProcess_Triangulate | aiProcess_FlipUVs);
+        importProfile.record(ImportStage::POST_PROCESS, postSample);
+    }
     
     if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
         std::cout << "ERROR::ASSIMP::" << import.GetErrorString() << std::endl;
         return false;
     }
     
-    directory = path.substr(0, path.find_last_of('/'));
-    processNode(scene->mRootNode, scene);
+    ThreadPool& pool = ThreadPool::shared();
+    StageSample graphSample;
     
-    printVertexInfo();
+    // Одинаковые по содержимому исходные меши сводятся к первому из них
+    std::vector<uint64_t> sourceHashes(scene->mNumMeshes);
+    pool.parallelFor(scene->mNumMeshes, [&](size_t i) {
+        sourceHashes[i] = hashSourceMesh(scene->mMeshes[i]);
+    });
+    // Меши с одинаковым хэшем сравниваются целиком, коллизия даёт ещё один канонический меш
+    std::vector<unsigned int> canonicalMeshes(scene->mNumMeshes);
+    std::unordered_map<uint64_t, std::vector<unsigned int>> canonicalByHash;
+    for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+        std::vector<unsigned int>& candidates = canonicalByHash[sourceHashes[i]];
+        canonicalMeshes[i] = i;
+        for (unsigned int candidate : candidates) {
+            if (sameSourceMesh(scene->mMeshes[candidate], scene->mMeshes[i])) {
+                canonicalMeshes[i] = candidate;
+                break;
+            }
+        }
+        if (canonicalMeshes[i] == i) candidates.push_back(i);
+    }
+    
+    // Сначала строим иерархию и собираем уникальные меши в порядке обхода, затем конвертируем параллельно
+    std::vector<unsigned int> meshRefs;
+    std::vector<int> meshSlots(scene->mNumMeshes, -1);
+    processNode(scene->mRootNode, scene, SCENE_NO_PARENT, canonicalMeshes, meshRefs, meshSlots);
+    sceneGraph.sortInstancesByMesh();
+    sceneGraph.updateWorldTransforms();
+    
+    // Кости и каналы анимации ссылаются на узлы по имени
+    std::unordered_map<std::string, uint32_t> nodeByName;
+    for (uint32_t node = 0; node < sceneGraph.getNodeCount(); node++) {
+        nodeByName.emplace(sceneGraph.getName(node), node);
+    }
+    importAnimations(scene, nodeByName, animations);
+    importProfile.record(ImportStage::SCENE_GRAPH, graphSample);
+    if (verbose && !animations.empty()) {
+        printAnimationReport();
+    }
+    if (verbose && sceneGraph.getMeshInstances().size() > meshRefs.size()) {
+        std::cout << "Instancing: " << meshRefs.size() << " unique meshes for "
+                  << sceneGraph.getMeshInstances().size() << " placements" << std::endl;
+    }
+    
+    meshes.resize(meshRefs.size());
+    meshTimings.resize(meshRefs.size());
+    missingNormals.resize(meshRefs.size());
+    optimizationReports.resize(optimizeMeshes ? meshRefs.size() : 0);
+    importProfile.beginMeshStages(meshRefs.size());
+    
+    // Предупреждения рабочих потоков печатаются после параллельного этапа, по порядку мешей
+    std::vector<std::vector<std::string>> unboundBones(meshRefs.size());
+    StageSample processSample;
+    pool.parallelFor(meshRefs.size(), [&](size_t i) {
+        StageSample convertSample;
+        meshTimings[i].sourceMesh = meshRefs[i];
+        meshes[i] = processMesh(scene->mMeshes[meshRefs[i]], scene, meshTimings[i]);
+        missingNormals[i] = !scene->mMeshes[meshRefs[i]]->HasNormals();
+        importBones(scene->mMeshes[meshRefs[i]], nodeByName, meshes[i], unboundBones[i]);
+        importProfile.recordMesh(i, ImportStage::CONVERT, convertSample,
+                                 meshes[i].vertices.size() * sizeof(StandardVertex) + meshes[i].indices.size() * sizeof(unsigned int));
+        
+        finishMesh(i);
+    });
+    importProfile.record(ImportStage::PROCESS_MESHES, processSample);
+    importProfile.finishMeshStages();
+    if (verbose) {
+        for (const auto& names : unboundBones) {
+            for (const std::string& name : names) {
+                std::cout << "Bone '" << name << "' has no node, bound to root" << std::endl;
+            }
+        }
+        std::cout << "Converted " << meshes.size() << " meshes on " << pool.getThreadCount() + 1
+                  << " threads in " << processSample.elapsedMs() << " ms" << std::endl;
+    }
+    
+    // Исходная сцена Assimp больше не нужна - освобождаем до записи кэша
+    memoryReport.peakRssBytes = getPeakRss();
+    import.FreeScene();
     return true;
 }
 
-void ModelParser::processNode(aiNode* node, const aiScene* scene) {
+// Стадии после конвертации - общие для Assimp и собственного загрузчика OBJ
+void ModelParser::finishMesh(size_t i) {
+    // Нормали нужны до оптимизации - сварка сравнивает вершины целиком
+    StageSample normalSample;
+    if (missingNormals[i]) {
+        TangentSpace::computeNormals(meshes[i], creaseAngle);
+    }
+    meshTimings[i].tangentMs = normalSample.elapsedMs();
+    importProfile.recordMesh(i, ImportStage::TANGENTS, normalSample);
+    
+    StageSample optimizeSample;
+    if (optimizeMeshes) {
+        optimizationReports[i] = MeshOptimizer::optimize(meshes[i]);
+    }
+    meshTimings[i].optimizeMs = optimizeSample.elapsedMs();
+    importProfile.recordMesh(i, ImportStage::OPTIMIZE, optimizeSample);
+    
+    // Касательные - после оптимизации, чтобы не переставлять их вместе с вершинами
+    StageSample tangentSample;
+    if (buildTangents) {
+        TangentSpace::computeTangents(meshes[i]);
+    }
+    meshTimings[i].tangentMs += tangentSample.elapsedMs();
+    importProfile.recordMesh(i, ImportStage::TANGENTS, tangentSample, meshes[i].tangents.size() * sizeof(VertexTangent));
+    
+    StageSample meshletSample;
+    if (buildMeshlets) {
+        MeshletBuilder::build(meshes[i]);
+    }
+    meshTimings[i].meshletMs = meshletSample.elapsedMs();
+    importProfile.recordMesh(i, ImportStage::MESHLETS, meshletSample, meshes[i].meshlets.size() * sizeof(Meshlet));
+    
+    StageSample lodSample;
+    size_t baseIndices = meshes[i].indices.size();
+    if (buildLods) {
+        MeshSimplifier::buildLodChain(meshes[i]);
+    }
+    meshTimings[i].lodMs = lodSample.elapsedMs();
+    importProfile.recordMesh(i, ImportStage::LODS, lodSample, (meshes[i].indices.size() - baseIndices) * sizeof(unsigned int));
+    
+    StageSample boundsSample;
+    BoundsBuilder::computeMesh(meshes[i].vertexData(), meshes[i].vertexCount(), meshes[i].bounds);
+    meshes[i].contentHash = computeContentHash(meshes[i]);
+    meshTimings[i].boundsMs = boundsSample.elapsedMs();
+    importProfile.recordMesh(i, ImportStage::BOUNDS, boundsSample);
+    
+    if (meshReadyCallback) {
+        meshReadyCallback(i, meshes.size());
+    }
+}
+
+bool ModelParser::isAnimated() const {
+    if (!animations.empty()) return true;
+    for (const auto& mesh : meshes) {
+        if (!mesh.skin.empty()) return true;
+    }
+    return false;
+}
+
+void ModelParser::finishImportProfile(bool fromCache) {
+    size_t vertexCount = 0, triangleCount = 0;
+    for (const auto& mesh : meshes) {
+        vertexCount += mesh.vertexCount();
+        triangleCount += mesh.baseIndexCount() / 3;
+    }
+    importProfile.setFromCache(fromCache);
+    importProfile.setThreadCount(ThreadPool::shared().getThreadCount() + 1);
+    importProfile.setSceneInfo(meshes.size(), vertexCount, triangleCount);
+    importProfile.setMemory(memoryReport.peakRssBytes, memoryReport.cpuMeshBytes);
+}
+
+void ModelParser::processNode(aiNode* node, const aiScene* scene, int parent, const std::vector<unsigned int>& canonicalMeshes,
+                              std::vector<unsigned int>& meshRefs, std::vector<int>& meshSlots) {
+    uint32_t nodeIndex = sceneGraph.addNode(parent, toGlm(node->mTransformation), node->mName.C_Str());
+    
+    // Меш, на который ссылаются несколько узлов, конвертируется один раз
     for(unsigned int i = 0; i < node->mNumMeshes; i++) {
-        aiMesh* mesh = scene->mMeshes[node->mMeshes[i]]; 
-        meshes.push_back(processMesh(mesh, scene));			
+        unsigned int source = canonicalMeshes[node->mMeshes[i]];
+        if (meshSlots[source] < 0) {
+            meshSlots[source] = (int)meshRefs.size();
+            meshRefs.push_back(source);
+        }
+        sceneGraph.addMeshInstance(nodeIndex, (uint32_t)meshSlots[source]);
     }
     
     for(unsigned int i = 0; i < node->mNumChildren; i++) {
-        processNode(node->mChildren[i], scene);
+        processNode(node->mChildren[i], scene, (int)nodeIndex, canonicalMeshes, meshRefs, meshSlots);
     }
 }
 
-StandardMesh ModelParser::processMesh(aiMesh* mesh, const aiScene* scene) {
+StandardMesh ModelParser::processMesh(aiMesh* mesh, const aiScene* scene, MeshTiming& timing) {
     StandardMesh standardMesh;
+    auto start = std::chrono::steady_clock::now();
+    
+    standardMesh.vertices.resize(mesh->mNumVertices);
+    const aiVector3D* uvs = mesh->mTextureCoords[0];
     
     for(unsigned int i = 0; i < mesh->mNumVertices; i++) {
-        StandardVertex vertex;
+        StandardVertex& vertex = standardMesh.vertices[i];
         
         vertex.position[0] = mesh->mVertices[i].x;
         vertex.position[1] = mesh->mVertices[i].y;
@@ -53,43 +552,38 @@ StandardMesh ModelParser::processMesh(aiMesh* mesh, const aiScene* scene) {
             vertex.normal[2] = 0.0f;
         }
         
-        if(mesh->mTextureCoords[0]) {
-            vertex.texCoords[0] = mesh->mTextureCoords[0][i].x; 
-            vertex.texCoords[1] = mesh->mTextureCoords[0][i].y;
+        if (uvs) {
+            vertex.texCoords[0] = uvs[i].x; 
+            vertex.texCoords[1] = uvs[i].y;
         } else {
             vertex.texCoords[0] = 0.0f;
             vertex.texCoords[1] = 0.0f;
         }
-        
-        standardMesh.vertices.push_back(vertex);
     }
     
+    timing.convertMs = elapsedMs(start);
+    
+    start = std::chrono::steady_clock::now();
+    size_t indexCount = 0;
+    for(unsigned int i = 0; i < mesh->mNumFaces; i++) {
+        indexCount += mesh->mFaces[i].mNumIndices;
+    }
+    standardMesh.indices.resize(indexCount);
+    
+    unsigned int* out = standardMesh.indices.data();
     for(unsigned int i = 0; i < mesh->mNumFaces; i++) {
-        aiFace face = mesh->mFaces[i];
+        const aiFace& face = mesh->mFaces[i];
         for(unsigned int j = 0; j < face.mNumIndices; j++)
-            standardMesh.indices.push_back(face.mIndices[j]);        
+            *out++ = face.mIndices[j];
     }
-    
-    createVertexBuffer(standardMesh);
+    timing.indexMs = elapsedMs(start);
     
     return standardMesh;
 }
 
-void ModelParser::createVertexBuffer(StandardMesh& mesh) {
-    mesh.vertexBuffer.clear();
-    
-    for (const auto& vertex : mesh.vertices) {
-        mesh.vertexBuffer.push_back(vertex.position[0]);
-        mesh.vertexBuffer.push_back(vertex.position[1]);
-        mesh.vertexBuffer.push_back(vertex.position[2]);
-        
-        mesh.vertexBuffer.push_back(vertex.normal[0]);
-        mesh.vertexBuffer.push_back(vertex.normal[1]);
-        mesh.vertexBuffer.push_back(vertex.normal[2]);
-        
-        mesh.vertexBuffer.push_back(vertex.texCoords[0]);
-        mesh.vertexBuffer.push_back(vertex.texCoords[1]);
-    }
+uint64_t ModelParser::computeContentHash(const StandardMesh& mesh) {
+    uint64_t hash = MeshBinaryCache::hashBytes(mesh.vertexData(), mesh.vertexCount() * sizeof(StandardVertex));
+    return MeshBinaryCache::hashBytes(mesh.indexData(), mesh.indexCount() * sizeof(unsigned int), hash);
 }
 
 void ModelParser::printVertexInfo() {
@@ -99,16 +593,122 @@ void ModelParser::printVertexInfo() {
     for (size_t meshIndex = 0; meshIndex < meshes.size(); meshIndex++) {
         const StandardMesh& mesh = meshes[meshIndex];
         std::cout << "\n--- Mesh " << meshIndex << " ---" << std::endl;
-        std::cout << "Vertices: " << mesh.vertices.size() << std::endl;
-        std::cout << "Indices: " << mesh.indices.size() << std::endl;
-        std::cout << "Vertex buffer size: " << mesh.vertexBuffer.size() << " floats" << std::endl;
+        std::cout << "Vertices: " << mesh.vertexCount() << std::endl;
+        std::cout << "Indices: " << mesh.indexCount() << std::endl;
+        std::cout << "Meshlets: " << mesh.meshletCount() << std::endl;
+        for (size_t lod = 1; lod < mesh.lods.size(); lod++) {
+            std::cout << "LOD " << lod << ": " << mesh.lods[lod].indexCount / 3 << " triangles, error "
+                      << mesh.lods[lod].error << std::endl;
+        }
+        std::cout << "Vertex buffer size: " << mesh.vertexCount() * sizeof(StandardVertex) << " bytes" << std::endl;
         
         std::cout << "First 5 vertices:" << std::endl;
-        for (size_t i = 0; i < std::min((size_t)5, mesh.vertices.size()); i++) {
-            const StandardVertex& vertex = mesh.vertices[i];
+        for (size_t i = 0; i < std::min((size_t)5, mesh.vertexCount()); i++) {
+            const float* position = mesh.vertexData()[i].position;
             std::cout << "  V" << i << ": Pos(" 
-                      << vertex.position[0] << ", " << vertex.position[1] << ", " << vertex.position[2] << ")" << std::endl;
+                      << position[0] << ", " << position[1] << ", " << position[2] << ")" << std::endl;
         }
     }
     std::cout << "=== END VERTEX INFORMATION ===\n" << std::endl;
-}
\ No newline at end of file
+}
+
+void ModelParser::printMeshTimings() const {
+    std::cout << "\n=== MESH CONVERSION TIMINGS ===" << std::endl;
+    for (size_t i = 0; i < meshTimings.size(); i++) {
+        const MeshTiming& timing = meshTimings[i];
+        std::cout << "Mesh " << i << " (source " << timing.sourceMesh << "): "
+                  << "convert " << timing.convertMs << " ms, "
+                  << "indices " << timing.indexMs << " ms, "
+                  << "tangents " << timing.tangentMs << " ms, "
+                  << "optimize " << timing.optimizeMs << " ms, "
+                  << "meshlets " << timing.meshletMs << " ms, "
+                  << "lods " << timing.lodMs << " ms, "
+                  << "bounds " << timing.boundsMs << " ms" << std::endl;
+    }
+    std::cout << "=== END MESH CONVERSION TIMINGS ===\n" << std::endl;
+}
+
+size_t ModelParser::getCpuMeshBytes() const {
+    size_t bytes = 0;
+    for (const auto& mesh : meshes) {
+        bytes += mesh.vertices.capacity() * sizeof(StandardVertex);
+        bytes += mesh.indices.capacity() * sizeof(unsigned int);
+        bytes += mesh.meshlets.capacity() * sizeof(Meshlet);
+        bytes += mesh.lods.capacity() * sizeof(MeshLod);
+        bytes += mesh.skin.capacity() * sizeof(VertexSkin);
+        bytes += mesh.bones.capacity() * sizeof(MeshBone);
+        bytes += mesh.tangents.capacity() * sizeof(VertexTangent);
+    }
+    return bytes;
+}
+
+void ModelParser::releaseCpuData() {
+    for (auto& mesh : meshes) {
+        // Скинирование каждый кадр читает вершины bind-позы и веса
+        if (!mesh.skin.empty()) continue;
+        
+        // Кластеры нужны для отсечения при отрисовке - переносим их из отображённого файла
+        if (mesh.mappedMeshlets) {
+            mesh.meshlets.assign(mesh.mappedMeshlets, mesh.mappedMeshlets + mesh.mappedMeshletCount);
+            mesh.mappedMeshlets = nullptr;
+            mesh.mappedMeshletCount = 0;
+        }
+        std::vector<StandardVertex>().swap(mesh.vertices);
+        std::vector<unsigned int>().swap(mesh.indices);
+        std::vector<VertexTangent>().swap(mesh.tangents);
+        mesh.mappedVertices = nullptr;
+        mesh.mappedTangents = nullptr;
+        mesh.mappedTangentCount = 0;
+        mesh.mappedIndices = nullptr;
+        mesh.mappedVertexCount = 0;
+        mesh.mappedIndexCount = 0;
+    }
+    mappedCache.reset();
+    mappedSource.reset();
+    
+    memoryReport.cpuMeshBytes = 0;
+    memoryReport.currentRssBytes = getCurrentRss();
+}
+
+void ModelParser::printMemoryReport() const {
+    std::cout << "Import memory: CPU mesh data " << memoryReport.cpuMeshBytes / 1024 << " KB"
+              << ", peak RSS " << memoryReport.peakRssBytes / (1024 * 1024) << " MB"
+              << ", steady RSS " << memoryReport.currentRssBytes / (1024 * 1024) << " MB" << std::endl;
+}
+
+void ModelParser::printAnimationReport() const {
+    size_t channels = 0, keysBefore = 0, keysAfter = 0, bytesBefore = 0, bytesAfter = 0;
+    for (const AnimationClip& clip : animations) {
+        channels += clip.channelCount();
+        keysBefore += clip.sourceKeys;
+        keysAfter += clip.keyCount();
+        bytesBefore += clip.sourceBytes;
+        bytesAfter += clip.byteSize();
+    }
+    
+    std::cout << "Animation: " << animations.size() << " clips, " << channels << " channels, keys "
+              << keysBefore << " -> " << keysAfter << ", " << bytesBefore / 1024.0 << " KB -> "
+              << bytesAfter / 1024.0 << " KB (" << (bytesAfter ? (double)bytesBefore / bytesAfter : 0.0)
+              << "x)" << std::endl;
+}
+
+void ModelParser::printOptimizationReport() const {
+    size_t verticesBefore = 0, verticesAfter = 0, triangles = 0;
+    double missesBefore = 0.0, missesAfter = 0.0;
+    
+    for (size_t i = 0; i < optimizationReports.size() && i < meshes.size(); i++) {
+        const MeshOptimizationReport& report = optimizationReports[i];
+        size_t meshTriangles = meshes[i].baseIndexCount() / 3;
+        verticesBefore += report.verticesBefore;
+        verticesAfter += report.verticesAfter;
+        triangles += meshTriangles;
+        missesBefore += report.before.acmr * meshTriangles;
+        missesAfter += report.after.acmr * meshTriangles;
+    }
+    if (triangles == 0) return;
+    
+    std::cout << "Mesh optimization: vertices " << verticesBefore << " -> " << verticesAfter
+              << ", ACMR " << missesBefore / triangles << " -> " << missesAfter / triangles
+              << ", ATVR " << (verticesBefore ? missesBefore / verticesBefore : 0.0)
+              << " -> " << (verticesAfter ? missesAfter / verticesAfter : 0.0) << std::endl;
+}
@@ -3,7 +3,15 @@
 
 #include <vector>
 #include <string>
+#include <memory>
+#include <functional>
+#include <cstdint>
 #include <assimp/scene.h>
+#include "scenegraph.h"
+#include "animation.h"
+#include "importprofile.h"
+
+class MappedFile;
 
 struct StandardVertex {
     float position[3];
@@ -11,26 +19,223 @@ struct StandardVertex {
     float texCoords[2];
 };
 
+static_assert(sizeof(StandardVertex) == 8 * sizeof(float), "StandardVertex must be tightly packed");
+
+// AABB и сфера вокруг его центра, охватывающая все вершины (она теснее половины диагонали)
+struct MeshBounds {
+    float min[3];
+    float max[3];
+    float center[3];
+    float radius;
+};
+
+// Кластер меша: непрерывный диапазон индексов со сферой и конусом нормалей для отсечения
+struct Meshlet {
+    unsigned int indexOffset;
+    unsigned int triangleCount;
+    unsigned int vertexCount;
+    float center[3];
+    float radius;
+    float coneAxis[3];
+    float coneCutoff;
+};
+
+const unsigned int MAX_MESH_LODS = 5;
+
+// Уровень детализации: диапазон в общем индексном буфере и его геометрическая ошибка
+struct MeshLod {
+    unsigned int indexOffset;
+    unsigned int indexCount;
+    float error;
+};
+
+const unsigned int MAX_BONE_INFLUENCES = 4;
+
+// До четырёх влияний на вершину: индексы в StandardMesh::bones и веса в долях 1/255 (сумма 255)
+struct VertexSkin {
+    uint16_t bones[MAX_BONE_INFLUENCES];
+    uint8_t weights[MAX_BONE_INFLUENCES];
+};
+
+static_assert(sizeof(VertexSkin) == 12, "VertexSkin must be tightly packed");
+
+// Касательная и знак битангенса: bitangent = cross(normal, direction) * handedness
+struct VertexTangent {
+    float direction[3];
+    float handedness;
+};
+
+struct MeshBone {
+    uint32_t node;    // узел SceneGraph, который двигает кость
+    glm::mat4 offset; // из пространства меша в пространство кости в bind-позе
+};
+
+// vertices - единственное CPU-хранилище вершин, оно же уходит в glBufferData без перепаковки
 struct StandardMesh {
     std::vector<StandardVertex> vertices;
     std::vector<unsigned int> indices;
-    std::vector<float> vertexBuffer;
+    std::vector<Meshlet> meshlets;
+    std::vector<MeshLod> lods; // lods[0] - полный меш, уровни 1.. дописаны в конец indices
+    MeshBounds bounds;
+    uint64_t contentHash = 0; // хэш вершин и индексов - по нему горячая перезагрузка находит неизменённые меши
+    std::vector<VertexSkin> skin; // параллельно вершинам; пусто - меш не скинирован
+    std::vector<MeshBone> bones;
+    std::vector<VertexTangent> tangents; // параллельно вершинам; пусто - у меша нет развёртки UV
+
+    // Меш из бинарного кэша: данные указывают прямо в отображённый файл
+    const StandardVertex* mappedVertices = nullptr;
+    const unsigned int* mappedIndices = nullptr;
+    const Meshlet* mappedMeshlets = nullptr;
+    const VertexTangent* mappedTangents = nullptr;
+    size_t mappedVertexCount = 0;
+    size_t mappedIndexCount = 0;
+    size_t mappedMeshletCount = 0;
+    size_t mappedTangentCount = 0;
+
+    const StandardVertex* vertexData() const { return mappedVertices ? mappedVertices : vertices.data(); }
+    size_t vertexCount() const { return mappedVertices ? mappedVertexCount : vertices.size(); }
+    const unsigned int* indexData() const { return mappedIndices ? mappedIndices : indices.data(); }
+    size_t indexCount() const { return mappedIndices ? mappedIndexCount : indices.size(); }
+    const Meshlet* meshletData() const { return mappedMeshlets ? mappedMeshlets : meshlets.data(); }
+    size_t meshletCount() const { return mappedMeshlets ? mappedMeshletCount : meshlets.size(); }
+    const VertexTangent* tangentData() const { return mappedTangents ? mappedTangents : tangents.data(); }
+    size_t tangentCount() const { return mappedTangents ? mappedTangentCount : tangents.size(); }
+    size_t baseIndexCount() const { return lods.empty() ? indexCount() : lods[0].indexCount; }
 };
 
+struct MeshTiming {
+    unsigned int sourceMesh;
+    double convertMs;
+    double indexMs;
+    double tangentMs;
+    double optimizeMs;
+    double meshletMs;
+    double lodMs;
+    double boundsMs;
+};
+
+struct ImportMemoryReport {
+    size_t cpuMeshBytes;
+    size_t peakRssBytes;
+    size_t currentRssBytes;
+};
+
+struct VertexCacheStats {
+    float acmr; // промахи кэша на треугольник
+    float atvr; // промахи кэша на уникальную вершину
+};
+
+struct MeshOptimizationReport {
+    size_t verticesBefore;
+    size_t verticesAfter;
+    VertexCacheStats before;
+    VertexCacheStats after;
+};
+
+// Вызывается из рабочих потоков, как только меш полностью готов
+typedef std::function<void(size_t meshIndex, size_t meshCount)> MeshReadyCallback;
+
 class ModelParser {
 public:
     ModelParser();
     bool loadModel(const std::string& path);
     const std::vector<StandardMesh>& getMeshes() const { return meshes; }
+    // Клипы анимации узлов; скинированные меши следуют за узлами своих костей
+    const std::vector<AnimationClip>& getAnimations() const { return animations; }
+    void printAnimationReport() const;
+    bool isAnimated() const;
+    // Иерархия узлов модели; меши в ней - экземпляры по индексу в getMeshes()
+    const SceneGraph& getSceneGraph() const { return sceneGraph; }
+    // Границы всех экземпляров с учётом мировых матриц узлов (bind-поза)
+    const MeshBounds& getSceneBounds() const { return sceneBounds; }
+    SceneGraph& getSceneGraph() { return sceneGraph; }
     void printVertexInfo();
-    
+    const std::vector<MeshTiming>& getMeshTimings() const { return meshTimings; }
+    void printMeshTimings() const;
+
+    void setUseBinaryCache(bool enabled) { useBinaryCache = enabled; }
+    bool getUseBinaryCache() const { return useBinaryCache; }
+    bool isLoadedFromCache() const { return mappedCache != nullptr; }
+
+    // Если CPU-копии не нужны, их можно выбросить после загрузки на GPU
+    void setKeepCpuCopies(bool keep) { keepCpuCopies = keep; }
+    bool getKeepCpuCopies() const { return keepCpuCopies; }
+    void releaseCpuData();
+    size_t getCpuMeshBytes() const;
+    const ImportMemoryReport& getMemoryReport() const { return memoryReport; }
+    void printMemoryReport() const;
+
+    void setOptimizeMeshes(bool enabled) { optimizeMeshes = enabled; }
+    bool getOptimizeMeshes() const { return optimizeMeshes; }
+    const std::vector<MeshOptimizationReport>& getOptimizationReports() const { return optimizationReports; }
+    void printOptimizationReport() const;
+
+    void setBuildMeshlets(bool enabled) { buildMeshlets = enabled; }
+    bool getBuildMeshlets() const { return buildMeshlets; }
+
+    void setMeshReadyCallback(MeshReadyCallback callback) { meshReadyCallback = callback; }
+
+    // Время, выделения и объём данных по стадиям последней загрузки (загрузку на GPU дописывает рендерер/загрузчик)
+    const ImportProfile& getImportProfile() const { return importProfile; }
+    ImportProfile& getImportProfile() { return importProfile; }
+
+    void setBuildLods(bool enabled) { buildLods = enabled; }
+    bool getBuildLods() const { return buildLods; }
+
+    // Меши без нормалей получают гладкие; грани, расходящиеся больше чем на угол (градусы), не сглаживаются
+    void setNormalCreaseAngle(float degrees) { creaseAngle = degrees; }
+    float getNormalCreaseAngle() const { return creaseAngle; }
+
+    // Касательные для карт нормалей - у мешей с развёрткой UV
+    void setBuildTangents(bool enabled) { buildTangents = enabled; }
+    bool getBuildTangents() const { return buildTangents; }
+
+    // OBJ и GLB читаются собственными загрузчиками; при неудаче - Assimp
+    void setUseNativeLoaders(bool enabled) { useNativeLoaders = enabled; }
+    bool getUseNativeLoaders() const { return useNativeLoaders; }
+
+    // Отпечаток настроек, меняющих данные в бинарном кэше; другой отпечаток - промах кэша
+    uint64_t getCacheOptionsHash() const;
+
+    // Без verbose печатаются только ошибки - для пакетной обработки в несколько потоков
+    void setVerbose(bool enabled) { verbose = enabled; }
+    bool getVerbose() const { return verbose; }
+
 private:
-    void processNode(aiNode* node, const aiScene* scene);
-    StandardMesh processMesh(aiMesh* mesh, const aiScene* scene);
-    void createVertexBuffer(StandardMesh& mesh);
-    
+    void processNode(aiNode* node, const aiScene* scene, int parent, const std::vector<unsigned int>& canonicalMeshes,
+                     std::vector<unsigned int>& meshRefs, std::vector<int>& meshSlots);
+    bool importObj(const std::string& path, uint64_t sourceSize);
+    bool importGlb(const std::string& path, uint64_t sourceSize);
+    bool importAssimp(const std::string& path, uint64_t sourceSize);
+    StandardMesh processMesh(aiMesh* mesh, const aiScene* scene, MeshTiming& timing);
+    void finishMesh(size_t meshIndex);
+    void finishMeshes();
+    static uint64_t computeContentHash(const StandardMesh& mesh);
+    void finishImportProfile(bool fromCache);
+
     std::vector<StandardMesh> meshes;
+    SceneGraph sceneGraph;
+    MeshBounds sceneBounds;
+    std::vector<AnimationClip> animations;
+    std::vector<MeshTiming> meshTimings;
+    std::vector<char> missingNormals; // по мешу: нормали строит TangentSpace
     std::string directory;
+
+    bool useBinaryCache;
+    bool keepCpuCopies;
+    bool optimizeMeshes;
+    bool buildMeshlets;
+    bool buildLods;
+    bool useNativeLoaders;
+    bool buildTangents;
+    float creaseAngle;
+    bool verbose;
+    MeshReadyCallback meshReadyCallback;
+    std::vector<MeshOptimizationReport> optimizationReports;
+    ImportMemoryReport memoryReport;
+    ImportProfile importProfile;
+    std::shared_ptr<MappedFile> mappedCache;
+    std::shared_ptr<MappedFile> mappedSource; // GLB, на буферы которого ссылаются меши
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,138 @@
+#include "quantize.h"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x007FFFFF;
+
+    if (((bits >> 23) & 0xFF) == 0xFF) {
+        return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    }
+    if (exponent >= 31) {
+        return (uint16_t)(sign | 0x7C00);
+    }
+    if (exponent <= 0) {
+        // Денормализованные half или ноль
+        if (exponent < -10) return (uint16_t)sign;
+        mantissa |= 0x00800000;
+        uint32_t shift = (uint32_t)(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1))) half++;
+        return (uint16_t)(sign | half);
+    }
+
+    uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) half++;
+    return (uint16_t)half;
+}
+
+static int16_t toSnorm16(float value) {
+    value = std::max(-1.0f, std::min(1.0f, value));
+    return (int16_t)std::lround(value * 32767.0f);
+}
+
+static uint16_t toUnorm16(float value) {
+    value = std::max(0.0f, std::min(1.0f, value));
+    return (uint16_t)std::lround(value * 65535.0f);
+}
+
+void encodeOctahedral(const float normal[3], int16_t out[2]) {
+    float x = normal[0], y = normal[1], z = normal[2];
+    float length = std::fabs(x) + std::fabs(y) + std::fabs(z);
+    if (length <= 0.0f) {
+        out[0] = 0;
+        out[1] = 0;
+        return;
+    }
+    x /= length;
+    y /= length;
+
+    if (z < 0.0f) {
+        float ox = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float oy = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = ox;
+        y = oy;
+    }
+
+    out[0] = toSnorm16(x);
+    out[1] = toSnorm16(y);
+}
+
+QuantizationParams identityQuantization() {
+    QuantizationParams params;
+    for (int k = 0; k < 3; k++) {
+        params.positionOffset[k] = 0.0f;
+        params.positionScale[k] = 1.0f;
+    }
+    for (int k = 0; k < 2; k++) {
+        params.uvOffset[k] = 0.0f;
+        params.uvScale[k] = 1.0f;
+    }
+    return params;
+}
+
+size_t getVertexStride(VertexFormat format) {
+    return format == VertexFormat::FLOAT32 ? sizeof(StandardVertex) : sizeof(CompactVertex);
+}
+
+QuantizationParams quantizeVertices(const StandardMesh& mesh, VertexFormat format,
+                                    std::vector<CompactVertex>& out) {
+    QuantizationParams params = identityQuantization();
+    const StandardVertex* vertices = mesh.vertexData();
+    size_t count = mesh.vertexCount();
+    out.resize(count);
+    if (count == 0) return params;
+
+    for (int k = 0; k < 3; k++) {
+        params.positionOffset[k] = (mesh.bounds.min[k] + mesh.bounds.max[k]) * 0.5f;
+        float halfExtent = (mesh.bounds.max[k] - mesh.bounds.min[k]) * 0.5f;
+        params.positionScale[k] = format == VertexFormat::COMPACT_SNORM16 && halfExtent > 0.0f ? halfExtent : 1.0f;
+    }
+
+    float uvMin[2] = {vertices[0].texCoords[0], vertices[0].texCoords[1]};
+    float uvMax[2] = {uvMin[0], uvMin[1]};
+    for (size_t i = 1; i < count; i++) {
+        for (int k = 0; k < 2; k++) {
+            uvMin[k] = std::min(uvMin[k], vertices[i].texCoords[k]);
+            uvMax[k] = std::max(uvMax[k], vertices[i].texCoords[k]);
+        }
+    }
+    for (int k = 0; k < 2; k++) {
+        params.uvOffset[k] = uvMin[k];
+        params.uvScale[k] = uvMax[k] > uvMin[k] ? uvMax[k] - uvMin[k] : 1.0f;
+    }
+
+    float invScale[3];
+    for (int k = 0; k < 3; k++) invScale[k] = 1.0f / params.positionScale[k];
+    float invUvScale[2] = {1.0f / params.uvScale[0], 1.0f / params.uvScale[1]};
+
+    for (size_t i = 0; i < count; i++) {
+        const StandardVertex& source = vertices[i];
+        CompactVertex& target = out[i];
+
+        for (int k = 0; k < 3; k++) {
+            float local = (source.position[k] - params.positionOffset[k]) * invScale[k];
+            target.position[k] = format == VertexFormat::COMPACT_SNORM16
+                ? (uint16_t)toSnorm16(local)
+                : floatToHalf(local);
+        }
+        target.position[3] = 0;
+
+        encodeOctahedral(source.normal, target.normal);
+
+        for (int k = 0; k < 2; k++) {
+            target.texCoords[k] = toUnorm16((source.texCoords[k] - params.uvOffset[k]) * invUvScale[k]);
+        }
+    }
+
+    return params;
+}
@@ -0,0 +1,42 @@
+#ifndef QUANTIZE_H
+#define QUANTIZE_H
+
+#include <vector>
+#include <cstdint>
+#include "parser.h"
+
+enum class VertexFormat {
+    FLOAT32,          // StandardVertex, 32 байта
+    COMPACT_HALF,     // half-позиции относительно центра меша, 16 байт
+    COMPACT_SNORM16   // snorm16-позиции в пределах bounds меша, 16 байт
+};
+
+const size_t VERTEX_FORMAT_COUNT = 3;
+
+// Нормаль в октаэдрической кодировке (snorm16 x2), UV в unorm16 относительно диапазона UV меша
+struct CompactVertex {
+    uint16_t position[4];
+    int16_t normal[2];
+    uint16_t texCoords[2];
+};
+
+static_assert(sizeof(CompactVertex) == 16, "CompactVertex must be 16 bytes");
+
+// Декодирование в шейдере: position = positionOffset + stored * positionScale
+struct QuantizationParams {
+    float positionOffset[3];
+    float positionScale[3];
+    float uvOffset[2];
+    float uvScale[2];
+};
+
+uint16_t floatToHalf(float value);
+void encodeOctahedral(const float normal[3], int16_t out[2]);
+
+QuantizationParams identityQuantization();
+QuantizationParams quantizeVertices(const StandardMesh& mesh, VertexFormat format,
+                                    std::vector<CompactVertex>& out);
+
+size_t getVertexStride(VertexFormat format);
+
+#endif
@@ -0,0 +1,76 @@
+#include "rangeallocator.h"
+#include <algorithm>
+#include <iterator>
+
+RangeAllocator::RangeAllocator() : capacity(0), used(0) {}
+
+void RangeAllocator::reset(size_t newCapacity) {
+    freeBlocks.clear();
+    capacity = newCapacity;
+    used = 0;
+    if (capacity > 0) freeBlocks[0] = capacity;
+}
+
+void RangeAllocator::grow(size_t newCapacity) {
+    if (newCapacity <= capacity) return;
+    size_t oldCapacity = capacity;
+    capacity = newCapacity;
+    insertFree(oldCapacity, newCapacity - oldCapacity);
+}
+
+bool RangeAllocator::allocate(size_t size, size_t alignment, size_t& offset) {
+    if (size == 0) return false;
+    if (alignment == 0) alignment = 1;
+
+    for (auto it = freeBlocks.begin(); it != freeBlocks.end(); ++it) {
+        size_t blockStart = it->first, blockSize = it->second;
+        size_t aligned = (blockStart + alignment - 1) / alignment * alignment;
+        size_t padding = aligned - blockStart;
+        if (padding + size > blockSize) continue;
+
+        // Выравнивающий зазор остаётся свободным блоком перед выделением
+        freeBlocks.erase(it);
+        if (padding > 0) freeBlocks[blockStart] = padding;
+        size_t tail = blockSize - padding - size;
+        if (tail > 0) freeBlocks[aligned + size] = tail;
+
+        offset = aligned;
+        used += size;
+        return true;
+    }
+    return false;
+}
+
+void RangeAllocator::free(size_t offset, size_t size) {
+    if (size == 0) return;
+    used -= std::min(used, size);
+    insertFree(offset, size);
+}
+
+void RangeAllocator::insertFree(size_t offset, size_t size) {
+    auto next = freeBlocks.lower_bound(offset);
+    if (next != freeBlocks.end() && offset + size == next->first) {
+        size += next->second;
+        next = freeBlocks.erase(next);
+    }
+    if (next != freeBlocks.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset) {
+            prev->second += size;
+            return;
+        }
+    }
+    freeBlocks[offset] = size;
+}
+
+size_t RangeAllocator::getLargestFree() const {
+    size_t largest = 0;
+    for (const auto& block : freeBlocks) largest = std::max(largest, block.second);
+    return largest;
+}
+
+float RangeAllocator::getFragmentation() const {
+    size_t freeBytes = capacity - used;
+    if (freeBytes == 0) return 0.0f;
+    return 1.0f - (float)getLargestFree() / (float)freeBytes;
+}
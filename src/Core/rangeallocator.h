@@ -0,0 +1,37 @@
+#ifndef RANGEALLOCATOR_H
+#define RANGEALLOCATOR_H
+
+#include <map>
+#include <cstddef>
+
+// Раздаёт диапазоны внутри одного большого буфера: список свободных блоков
+// по смещению, первый подходящий, соседние блоки сливаются при освобождении.
+// Единица смещения задаёт вызывающий (вершины, байты).
+class RangeAllocator {
+public:
+    RangeAllocator();
+
+    void reset(size_t capacity);
+    // Хвост до новой ёмкости становится свободным блоком
+    void grow(size_t newCapacity);
+
+    bool allocate(size_t size, size_t alignment, size_t& offset);
+    // size - тот же, что при выделении
+    void free(size_t offset, size_t size);
+
+    size_t getCapacity() const { return capacity; }
+    size_t getUsed() const { return used; }
+    size_t getFreeBlockCount() const { return freeBlocks.size(); }
+    size_t getLargestFree() const;
+    // 1 - наибольший блок / всё свободное: 0 - свободное место одним куском
+    float getFragmentation() const;
+
+private:
+    void insertFree(size_t offset, size_t size);
+
+    std::map<size_t, size_t> freeBlocks; // смещение -> размер
+    size_t capacity;
+    size_t used;
+};
+
+#endif
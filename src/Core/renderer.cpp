@@ -1,5 +1,13 @@
 #include "renderer.h"
+#include "meshlet.h"
+#include "normalmatrix.h"
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <chrono>
+#include <cstring>
+#include <unordered_set>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -9,19 +17,112 @@ const char* vertexShaderSource = R"(
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in mat4 instanceMatrix;
+layout (location = 9) in mat3 instanceNormalMatrix;
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
+out vec3 Color;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Раскладки блоков - FrameUniforms и ObjectUniforms в renderer.h
+layout (std140) uniform FrameBlock {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition; // w - время
+};
+
+// Распаковка квантованных вершин (см. quantize.h)
+layout (std140) uniform ObjectBlock {
+    mat4 model;
+    mat3 normalMatrix; // обратная транспонированная к model, посчитана на CPU
+    vec4 objectColor;
+    vec4 positionOffset;
+    vec4 positionScale;
+    vec4 uvTransform;  // xy - смещение, zw - масштаб
+    uvec4 objectFlags; // x - октаэдрические нормали
+};
+
+vec3 decodeOctahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+void main() {
+    vec3 position = positionOffset.xyz + aPos * positionScale.xyz;
+    vec3 normal = objectFlags.x != 0u ? decodeOctahedral(aNormal.xy) : aNormal;
+    
+    mat4 world = model * instanceMatrix;
+    FragPos = vec3(world * vec4(position, 1.0));
+#ifdef SHADER_INVERSE_NORMALS
+    Normal = mat3(transpose(inverse(world))) * normal;
+#else
+    // Матрица нормалей произведения - произведение матриц нормалей
+    Normal = normalMatrix * (instanceNormalMatrix * normal);
+#endif
+    TexCoords = uvTransform.xy + aTexCoords * uvTransform.zw;
+    Color = objectColor.rgb;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
+)";
+
+// Вариант для glMultiDrawElementsIndirect: всё, что в обычном пути лежит в блоке объекта,
+// берётся из SSBO по индексу отрисовки. gl_DrawID появился только в 4.6,
+// поэтому индекс приходит инстансированным атрибутом через baseInstance команды.
+const char* indirectVertexShaderSource = R"(
+#version 430 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 8) in uint drawIndex;
+
+struct DrawData {
+    mat4 world;
+    mat3 normalMatrix;
+    vec4 positionOffset;
+    vec4 positionScale;
+    vec4 uvTransform; // xy - смещение, zw - масштаб
+    uvec4 flags;      // x - материал, y - октаэдрические нормали
+};
+
+layout (std430, binding = 0) readonly buffer DrawBuffer { DrawData draws[]; };
+layout (std430, binding = 1) readonly buffer MaterialBuffer { vec4 materialColors[]; };
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+out vec3 Color;
+
+layout (std140) uniform FrameBlock {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+};
+
+vec3 decodeOctahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
 
 void main() {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
-    TexCoords = aTexCoords;
+    DrawData draw = draws[drawIndex];
+    vec3 position = draw.positionOffset.xyz + aPos * draw.positionScale.xyz;
+    vec3 normal = draw.flags.y != 0u ? decodeOctahedral(aNormal.xy) : aNormal;
+    
+    FragPos = vec3(draw.world * vec4(position, 1.0));
+#ifdef SHADER_INVERSE_NORMALS
+    Normal = mat3(transpose(inverse(draw.world))) * normal;
+#else
+    Normal = draw.normalMatrix * normal;
+#endif
+    TexCoords = draw.uvTransform.xy + aTexCoords * draw.uvTransform.zw;
+    Color = materialColors[draw.flags.x].rgb;
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
 )";
@@ -33,39 +134,101 @@ out vec4 FragColor;
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
+in vec3 Color;
+
+layout (std140) uniform FrameBlock {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+};
 
-uniform vec3 objectColor;
-uniform vec3 lightPos;
-uniform vec3 lightColor;
-uniform vec3 viewPos;
+layout (std140) uniform LightBlock {
+    vec4 lightPosition;
+    vec4 lightColor;
+};
 
 void main() {
     float ambientStrength = 0.3;
-    vec3 ambient = ambientStrength * lightColor;
+    vec3 ambient = ambientStrength * lightColor.rgb;
     
     vec3 norm = normalize(Normal);
-    vec3 lightDir = normalize(lightPos - FragPos);
+    vec3 lightDir = normalize(lightPosition.xyz - FragPos);
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diff * lightColor;
+    vec3 diffuse = diff * lightColor.rgb;
     
     float specularStrength = 0.5;
-    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 viewDir = normalize(cameraPosition.xyz - FragPos);
     vec3 reflectDir = reflect(-lightDir, norm);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
-    vec3 specular = specularStrength * spec * lightColor;
+    vec3 specular = specularStrength * spec * lightColor.rgb;
     
-    vec3 result = (ambient + diffuse + specular) * objectColor;
+    vec3 result = (ambient + diffuse + specular) * Color;
     FragColor = vec4(result, 1.0);
 }
 )";
 
+// Цвет меша - по его индексу в сцене
+const glm::vec3 MATERIAL_COLORS[] = {
+    glm::vec3(0.8f, 0.3f, 0.2f),
+    glm::vec3(0.2f, 0.8f, 0.3f),
+    glm::vec3(0.3f, 0.2f, 0.8f),
+    glm::vec3(0.8f, 0.8f, 0.2f),
+    glm::vec3(0.8f, 0.2f, 0.8f),
+    glm::vec3(0.2f, 0.8f, 0.8f)
+};
+const size_t MATERIAL_COUNT = sizeof(MATERIAL_COLORS) / sizeof(MATERIAL_COLORS[0]);
+
+// Трансформ одиночного, не инстансированного вызова
+static const InstanceTransform IDENTITY_INSTANCE = {glm::mat4(1.0f), packNormalMatrix(glm::mat3(1.0f))};
+
+// Исходник с #define сразу после строки #version
+static std::string withDefine(const char* source, const char* define) {
+    std::string result(source);
+    size_t lineEnd = result.find('\n', result.find("#version"));
+    if (lineEnd == std::string::npos) return result;
+    result.insert(lineEnd + 1, std::string("#define ") + define + "\n");
+    return result;
+}
+
 Renderer::Renderer() 
     : window(nullptr), 
       camera(glm::vec3(0.0f, 0.0f, 5.0f)),
+      lightBuffer(0),
+      lightUniforms(),
+      lightValid(false),
       lastX(400.0f), lastY(300.0f), firstMouse(true),
       deltaTime(0.0f), lastFrame(0.0f),
       animateModel(true),
-      sprintEnabled(false) {}
+      sprintEnabled(false),
+      clusterCulling(true),
+      coneCulling(false),
+      modelFrustum(),
+      modelCameraPosition(0.0f),
+      renderStats(),
+      boundVertexArray(0),
+      lodSelection(true),
+      lodErrorThreshold(1.0f),
+      lodHysteresis(0.25f),
+      lodPixelScale(1.0f),
+      instancing(true),
+      instanceBuffer(0),
+      multiDrawSupported(false),
+      multiDraw(true),
+      indirectBuffer(0),
+      drawDataBuffer(0),
+      materialBuffer(0),
+      drawIndexBuffer(0),
+      drawIndexCapacity(0),
+      cpuNormalMatrix(true),
+      timerFrame(0),
+      gpuTimeMs(0.0),
+      gpuTimedVertices(0),
+      gpuTimedFrames(0) {
+    for (size_t i = 0; i < TIMER_QUERY_COUNT; i++) {
+        timerQueries[i] = 0;
+        timerVertices[i] = 0;
+    }
+}
 
 Renderer::~Renderer() {
     cleanup();
@@ -74,11 +237,17 @@ Renderer::~Renderer() {
 bool Renderer::initialize() {
     if (!glfwInit()) return false;
     
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    // 4.3 нужен для multi-draw indirect; без него - обычный 3.3 и отрисовка по вызову на меш
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     
     window = glfwCreateWindow(800, 600, "3D Model Viewer", nullptr, nullptr);
+    if (!window) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        window = glfwCreateWindow(800, 600, "3D Model Viewer", nullptr, nullptr);
+    }
     if (!window) {
         glfwTerminate();
         return false;
@@ -107,6 +276,44 @@ bool Renderer::initialize() {
     glEnable(GL_DEPTH_TEST);
     std::cout << "OpenGL version: " << glGetString(GL_VERSION) << std::endl;
     
+    if (!sceneProgram.build("scene", vertexShaderSource, fragmentShaderSource) ||
+        !bindUniformBlocks(sceneProgram)) {
+        return false;
+    }
+    std::cout << "Shaders compiled successfully" << std::endl;
+    sceneProgram.printReflection();
+    
+    if (GLEW_VERSION_4_3 && indirectProgram.build("scene-indirect", indirectVertexShaderSource, fragmentShaderSource)) {
+        multiDrawSupported = bindUniformBlocks(indirectProgram);
+    }
+    
+    // Варианты с обращением в шейдере нужны только для замера - без них N ничего не делает
+    std::string referenceSource = withDefine(vertexShaderSource, "SHADER_INVERSE_NORMALS");
+    if (!referenceSceneProgram.build("scene-shader-inverse", referenceSource.c_str(), fragmentShaderSource) ||
+        !bindUniformBlocks(referenceSceneProgram)) {
+        referenceSceneProgram.destroy();
+    }
+    if (multiDrawSupported) {
+        referenceSource = withDefine(indirectVertexShaderSource, "SHADER_INVERSE_NORMALS");
+        if (!referenceIndirectProgram.build("scene-indirect-shader-inverse", referenceSource.c_str(), fragmentShaderSource) ||
+            !bindUniformBlocks(referenceIndirectProgram)) {
+            referenceIndirectProgram.destroy();
+        }
+    }
+    glGenQueries((GLsizei)TIMER_QUERY_COUNT, timerQueries);
+    
+    // Данные кадра и объектов - в кольце, свет - в своём буфере, меняется редко
+    if (!uniformRing.create(UNIFORM_RING_REGION_BYTES)) {
+        return false;
+    }
+    glGenBuffers(1, &lightBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, lightBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(LightUniforms), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, LIGHT_UNIFORM_BINDING, lightBuffer);
+    lightValid = false;
+    std::cout << "Multi-draw indirect: " << (multiDrawSupported ? "available" : "unavailable, per-draw fallback") << std::endl;
+    
     std::cout << "\n=== CONTROLS ===" << std::endl;
     std::cout << "WASD - Move camera" << std::endl;
     std::cout << "Space - Move up" << std::endl;
@@ -116,6 +323,8 @@ bool Renderer::initialize() {
     std::cout << "Mouse Wheel - Zoom" << std::endl;
     std::cout << "R - Toggle model rotation" << std::endl;
     std::cout << "F - Toggle sprint mode" << std::endl;
+    std::cout << "M - Toggle multi-draw indirect" << std::endl;
+    std::cout << "N - Toggle CPU normal matrix / shader inverse (benchmark)" << std::endl;
     std::cout << "ESC - Exit" << std::endl;
     std::cout << "================\n" << std::endl;
     
@@ -123,13 +332,35 @@ bool Renderer::initialize() {
 }
 
 void Renderer::cleanup() {
-    for (auto vao : VAOs) glDeleteVertexArrays(1, &vao);
-    for (auto vbo : VBOs) glDeleteBuffers(1, &vbo);
-    for (auto ebo : EBOs) glDeleteBuffers(1, &ebo);
-    
-    VAOs.clear();
-    VBOs.clear();
-    EBOs.clear();
+    meshCache.clear();
+    lodState.clear();
+    if (instanceBuffer != 0) {
+        glDeleteBuffers(1, &instanceBuffer);
+        instanceBuffer = 0;
+    }
+    GLuint indirectBuffers[] = {indirectBuffer, drawDataBuffer, materialBuffer, drawIndexBuffer};
+    for (GLuint buffer : indirectBuffers) {
+        if (buffer != 0) glDeleteBuffers(1, &buffer);
+    }
+    indirectBuffer = drawDataBuffer = materialBuffer = drawIndexBuffer = 0;
+    drawIndexCapacity = 0;
+    sceneProgram.destroy();
+    indirectProgram.destroy();
+    referenceSceneProgram.destroy();
+    referenceIndirectProgram.destroy();
+    if (timerQueries[0] != 0) {
+        glDeleteQueries((GLsizei)TIMER_QUERY_COUNT, timerQueries);
+        for (size_t i = 0; i < TIMER_QUERY_COUNT; i++) {
+            timerQueries[i] = 0;
+            timerVertices[i] = 0;
+        }
+    }
+    uniformRing.destroy();
+    if (lightBuffer != 0) {
+        glDeleteBuffers(1, &lightBuffer);
+        lightBuffer = 0;
+    }
+    multiDrawSupported = false;
     
     if (window) {
         glfwDestroyWindow(window);
@@ -216,6 +447,26 @@ void Renderer::processInput(float deltaTime) {
         fKeyPressed = false;
     }
     
+    static bool mKeyPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS && !mKeyPressed) {
+        multiDraw = !multiDraw;
+        std::cout << "Submission: " << (multiDraw && multiDrawSupported ? "MULTI-DRAW INDIRECT" : "PER-DRAW") << std::endl;
+        mKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_RELEASE) {
+        mKeyPressed = false;
+    }
+    
+    static bool nKeyPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS && !nKeyPressed) {
+        setCpuNormalMatrix(!cpuNormalMatrix);
+        std::cout << "Normal matrix: " << (cpuNormalMatrix ? "CPU, per object" : "SHADER INVERSE, per vertex") << std::endl;
+        nKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_N) == GLFW_RELEASE) {
+        nKeyPressed = false;
+    }
+    
     if (sprintEnabled && !shiftPressed) {
         camera.SetMovementSpeed(baseSpeed * 3.0f);
     }
@@ -241,9 +492,81 @@ void Renderer::scrollCallback(double xoffset, double yoffset) {
     camera.ProcessMouseScroll(yoffset);
 }
 
-void Renderer::renderModel(const ModelParser& model, GLuint shaderProgram) {
-    glUseProgram(shaderProgram);
+void Renderer::setCpuNormalMatrix(bool enabled) {
+    cpuNormalMatrix = enabled;
+    // Замер начинается заново, чтобы не смешивать варианты
+    gpuTimeMs = 0.0;
+    gpuTimedVertices = 0;
+    gpuTimedFrames = 0;
+    for (size_t i = 0; i < TIMER_QUERY_COUNT; i++) timerVertices[i] = 0;
+}
+
+ShaderProgram& Renderer::currentProgram(bool indirect) {
+    ShaderProgram& reference = indirect ? referenceIndirectProgram : referenceSceneProgram;
+    if (!cpuNormalMatrix && reference.isValid()) return reference;
+    return indirect ? indirectProgram : sceneProgram;
+}
+
+// Результат запроса этого слота запущен TIMER_QUERY_COUNT кадров назад; не готов - пропускается
+void Renderer::beginGpuTimer() {
+    if (timerQueries[0] == 0) return;
+    size_t slot = timerFrame % TIMER_QUERY_COUNT;
+    if (timerVertices[slot] > 0) {
+        GLint available = 0;
+        glGetQueryObjectiv(timerQueries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(timerQueries[slot], GL_QUERY_RESULT, &nanoseconds);
+            gpuTimeMs += (double)nanoseconds / 1e6;
+            gpuTimedVertices += timerVertices[slot];
+            gpuTimedFrames++;
+        }
+        timerVertices[slot] = 0;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, timerQueries[slot]);
+}
+
+void Renderer::endGpuTimer(size_t vertices) {
+    if (timerQueries[0] == 0) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    timerVertices[timerFrame % TIMER_QUERY_COUNT] = vertices;
+    timerFrame++;
+}
+
+bool Renderer::bindUniformBlocks(ShaderProgram& program) {
+    return program.bindUniformBlock("FrameBlock", FRAME_UNIFORM_BINDING, sizeof(FrameUniforms)) &&
+           program.bindUniformBlock("LightBlock", LIGHT_UNIFORM_BINDING, sizeof(LightUniforms)) &&
+           program.bindUniformBlock("ObjectBlock", OBJECT_UNIFORM_BINDING, sizeof(ObjectUniforms));
+}
+
+// Свет загружается, только когда он изменился
+void Renderer::updateLight(const glm::vec3& position, const glm::vec3& color) {
+    LightUniforms light;
+    light.position = glm::vec4(position, 1.0f);
+    light.color = glm::vec4(color, 1.0f);
+    if (lightValid && std::memcmp(&light, &lightUniforms, sizeof(LightUniforms)) == 0) return;
     
+    lightUniforms = light;
+    lightValid = true;
+    glBindBuffer(GL_UNIFORM_BUFFER, lightBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightUniforms), &lightUniforms);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+static ObjectUniforms makeObjectUniforms(const glm::mat4& model, const glm::vec3& color, const GpuMesh& gpuMesh) {
+    const QuantizationParams& q = gpuMesh.quantization;
+    ObjectUniforms object;
+    object.model = model;
+    object.normalMatrix = packNormalMatrix(computeNormalMatrix(model));
+    object.color = glm::vec4(color, 1.0f);
+    object.positionOffset = glm::vec4(glm::make_vec3(q.positionOffset), 0.0f);
+    object.positionScale = glm::vec4(glm::make_vec3(q.positionScale), 0.0f);
+    object.uvTransform = glm::vec4(q.uvOffset[0], q.uvOffset[1], q.uvScale[0], q.uvScale[1]);
+    object.flags = glm::uvec4(gpuMesh.format != VertexFormat::FLOAT32 ? 1u : 0u, 0u, 0u, 0u);
+    return object;
+}
+
+void Renderer::renderModel(const ModelParser& model) {
     glm::mat4 modelMatrix = glm::mat4(1.0f);
     modelMatrix = glm::translate(modelMatrix, glm::vec3(0.0f, 0.0f, 0.0f)); 
     modelMatrix = glm::scale(modelMatrix, glm::vec3(1.0f, 1.0f, 1.0f));
@@ -265,29 +588,22 @@ void Renderer::renderModel(const ModelParser& model, GLuint shaderProgram) {
         1000000.0f
     );
     
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(modelMatrix));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    bool indirect = multiDraw && multiDrawSupported;
+    currentProgram(indirect).use();
     
-    glUniform3f(glGetUniformLocation(shaderProgram, "lightColor"), 1.0f, 1.0f, 1.0f);
-    glUniform3f(glGetUniformLocation(shaderProgram, "lightPos"), 2.0f, 5.0f, 2.0f);
-    glUniform3f(glGetUniformLocation(shaderProgram, "viewPos"), 
-                camera.GetPosition().x, camera.GetPosition().y, camera.GetPosition().z);
+    // Конус нормалей отбрасывает только задние грани - без GL_CULL_FACE они видны
+    coneCulling = glIsEnabled(GL_CULL_FACE) == GL_TRUE;
+    lodPixelScale = (float)height / (2.0f * tanf(glm::radians(camera.GetZoom()) * 0.5f));
+    
+    updateLight(glm::vec3(2.0f, 5.0f, 2.0f), glm::vec3(1.0f, 1.0f, 1.0f));
     
     const auto& meshes = model.getMeshes();
-    std::vector<glm::vec3> colors = {
-        glm::vec3(0.8f, 0.3f, 0.2f),
-        glm::vec3(0.2f, 0.8f, 0.3f),
-        glm::vec3(0.3f, 0.2f, 0.8f),
-        glm::vec3(0.8f, 0.8f, 0.2f),
-        glm::vec3(0.8f, 0.2f, 0.8f),
-        glm::vec3(0.2f, 0.8f, 0.8f)
-    };
     
     static int frameCounter = 0;
     static float lastInfoTime = 0.0f;
     frameCounter++;
     
+    // Статистика - за предыдущий кадр
     float currentTime = glfwGetTime();
     if (currentTime - lastInfoTime > 2.0f) {
         glm::vec3 camPos = camera.GetPosition();
@@ -300,91 +616,461 @@ void Renderer::renderModel(const ModelParser& model, GLuint shaderProgram) {
                   << " Sprint: " << (sprintEnabled ? "ON" : "OFF")
                   << std::endl;
         
+        std::cout << "Triangles: " << renderStats.trianglesDrawn << "/" << renderStats.fullDetailTriangles
+                  << " Draws: " << renderStats.drawCalls
+                  << " Instances: " << renderStats.instancesDrawn
+                  << " VAO binds: " << renderStats.vertexArrayBinds;
+        if (clusterCulling && renderStats.totalClusters > 0) {
+            std::cout << " Clusters: " << renderStats.visibleClusters << "/" << renderStats.totalClusters;
+        }
+        std::cout << std::endl;
+        std::cout << "Submit: " << renderStats.submitMs << " ms ("
+                  << (renderStats.indirectCommands > 0 ? "multi-draw indirect, " : "per-draw");
+        if (renderStats.indirectCommands > 0) std::cout << renderStats.indirectCommands << " commands";
+        std::cout << ")" << " Uniform ring: " << renderStats.uniformBlocks << " blocks, "
+                  << renderStats.uniformBytes / 1024 << " KB in one upload" << std::endl;
+        // Вершины - индексы отправленных треугольников, кэш после трансформации не учитывается
+        if (gpuTimedFrames > 0 && gpuTimeMs > 0.0) {
+            bool shaderInverse = &currentProgram(indirect) != (indirect ? &indirectProgram : &sceneProgram);
+            std::cout << "GPU: " << gpuTimeMs / gpuTimedFrames << " ms/frame, "
+                      << (double)gpuTimedVertices / (gpuTimeMs * 1000.0) << " M vertices/s"
+                      << " (normal matrix: " << (shaderInverse ? "shader inverse" : "CPU") << ")" << std::endl;
+        }
+        gpuTimeMs = 0.0;
+        gpuTimedVertices = 0;
+        gpuTimedFrames = 0;
+        
         lastInfoTime = currentTime;
     }
+    renderStats = RenderStats();
+    boundVertexArray = 0;
     
-    for (size_t i = 0; i < meshes.size(); i++) {
-        glm::vec3 color = colors[i % colors.size()];
-        glUniform3f(glGetUniformLocation(shaderProgram, "objectColor"), color.r, color.g, color.b);
-        renderStandardMesh(meshes[i], shaderProgram);
+    glm::mat4 viewProjection = projection * view;
+    Frustum sceneFrustum = Frustum::fromMatrix(viewProjection * modelMatrix);
+    auto submitStart = std::chrono::steady_clock::now();
+    beginGpuTimer();
+    
+    // Кадр - первый блок в своей области кольца; общий для обеих программ
+    FrameUniforms frame;
+    frame.view = view;
+    frame.projection = projection;
+    frame.cameraPosition = glm::vec4(camera.GetPosition(), currentTime);
+    uniformRing.beginFrame();
+    size_t frameOffset = uniformRing.allocate(frame);
+    
+    if (indirect) {
+        uniformRing.flush();
+        uniformRing.bind(FRAME_UNIFORM_BINDING, frameOffset, sizeof(FrameUniforms));
+        renderIndirect(model, modelMatrix, sceneFrustum);
+    } else {
+        // Без массива экземпляров трансформ экземпляра - единичный
+        setConstantInstanceTransform(IDENTITY_INSTANCE);
+        
+        // Экземпляры отсортированы по мешу: повторяющиеся размещения идут одним диапазоном.
+        // Сначала блоки всех объектов пишутся в кольцо и уходят одной загрузкой,
+        // затем каждый вызов только привязывает свой диапазон
+        const SceneGraph& sceneGraph = model.getSceneGraph();
+        const std::vector<MeshInstance>& instances = sceneGraph.getMeshInstances();
+        objectDraws.clear();
+        for (size_t begin = 0; begin < instances.size();) {
+            size_t end = begin + 1;
+            while (end < instances.size() && instances[end].mesh == instances[begin].mesh) end++;
+            
+            uint32_t meshIndex = instances[begin].mesh;
+            MeshHandle handle;
+            const GpuMesh* gpuMesh = meshIndex < meshes.size() ? residentMesh(meshes[meshIndex], handle) : nullptr;
+            if (gpuMesh) {
+                const glm::vec3& color = MATERIAL_COLORS[meshIndex % MATERIAL_COUNT];
+                if (instancing && end - begin > 1) {
+                    ObjectDraw draw = {meshIndex, begin, end, uniformRing.allocate(makeObjectUniforms(modelMatrix, color, *gpuMesh))};
+                    objectDraws.push_back(draw);
+                } else {
+                    for (size_t i = begin; i < end; i++) {
+                        glm::mat4 instanceMatrix = modelMatrix * sceneGraph.getWorldTransform(instances[i].node);
+                        ObjectDraw draw = {meshIndex, i, i + 1, uniformRing.allocate(makeObjectUniforms(instanceMatrix, color, *gpuMesh))};
+                        objectDraws.push_back(draw);
+                    }
+                }
+            }
+            begin = end;
+        }
+        uniformRing.flush();
+        uniformRing.bind(FRAME_UNIFORM_BINDING, frameOffset, sizeof(FrameUniforms));
+        
+        for (const ObjectDraw& draw : objectDraws) {
+            uniformRing.bind(OBJECT_UNIFORM_BINDING, draw.uniformOffset, sizeof(ObjectUniforms));
+            const StandardMesh& mesh = meshes[draw.mesh];
+            if (draw.end - draw.begin > 1) {
+                renderInstancedMesh(mesh, sceneGraph, &instances[draw.begin], draw.end - draw.begin,
+                                    modelMatrix, sceneFrustum);
+            } else {
+                // Одиночный экземпляр: фрустум и камера в пространстве меша для отсечения кластеров
+                glm::mat4 instanceMatrix = modelMatrix * sceneGraph.getWorldTransform(instances[draw.begin].node);
+                modelFrustum = Frustum::fromMatrix(viewProjection * instanceMatrix);
+                modelCameraPosition = glm::vec3(glm::inverse(instanceMatrix) * glm::vec4(camera.GetPosition(), 1.0f));
+                renderStandardMesh(mesh, instances[draw.begin].node);
+                renderStats.instancesDrawn++;
+            }
+        }
     }
+    glBindVertexArray(0);
+    endGpuTimer(renderStats.trianglesDrawn * 3);
+    
+    renderStats.uniformBlocks = uniformRing.getFrameBlocks();
+    renderStats.uniformBytes = uniformRing.getFrameBytes();
+    renderStats.submitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submitStart).count();
 }
 
-GLuint Renderer::createMeshBuffers(const StandardMesh& mesh) {
-    GLuint VAO, VBO, EBO;
+// Ключ уровня для группы экземпляров, нарисованной одним инстансированным вызовом
+const uint32_t INSTANCE_GROUP_NODE = 0xFFFFFFFFu;
+
+// Пакет - VAO формата и тип индексов: у одного glMultiDrawElementsIndirect они общие
+static size_t getBatchIndex(const GpuMesh& gpuMesh) {
+    return (size_t)gpuMesh.format * 2 + (gpuMesh.indexType == GL_UNSIGNED_INT ? 1 : 0);
+}
+
+void Renderer::renderIndirect(const ModelParser& model, const glm::mat4& modelMatrix, const Frustum& sceneFrustum) {
+    const auto& meshes = model.getMeshes();
+    const SceneGraph& sceneGraph = model.getSceneGraph();
     
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+    drawData.clear();
+    for (auto& batch : indirectBatches) batch.clear();
     
-    glBindVertexArray(VAO);
+    // Экземпляр - одна команда: отсечение по сфере меша и LOD по его расстоянию.
+    // Кластеры здесь не отсекаются - это делает только путь с вызовом на меш
+    for (const MeshInstance& instance : sceneGraph.getMeshInstances()) {
+        if (instance.mesh >= meshes.size()) continue;
+        const StandardMesh& mesh = meshes[instance.mesh];
+        
+        MeshHandle handle;
+        const GpuMesh* gpuMesh = residentMesh(mesh, handle);
+        if (!gpuMesh) continue;
+        
+        GLsizei baseIndexCount = mesh.lods.empty() ? gpuMesh->indexCount : (GLsizei)mesh.lods[0].indexCount;
+        renderStats.fullDetailTriangles += baseIndexCount / 3;
+        
+        // sceneFrustum уже в пространстве модели - сфера переводится только трансформом узла
+        const glm::mat4& nodeWorld = sceneGraph.getWorldTransform(instance.node);
+        glm::vec3 worldCenter = glm::vec3(nodeWorld * glm::vec4(mesh.bounds.center[0], mesh.bounds.center[1], mesh.bounds.center[2], 1.0f));
+        float scale = std::max(glm::length(glm::vec3(nodeWorld[0])),
+                               std::max(glm::length(glm::vec3(nodeWorld[1])), glm::length(glm::vec3(nodeWorld[2]))));
+        if (clusterCulling && mesh.skin.empty() && !sceneFrustum.intersectsSphere(&worldCenter.x, mesh.bounds.radius * scale)) continue;
+        
+        glm::mat4 world = modelMatrix * nodeWorld;
+        modelCameraPosition = glm::vec3(glm::inverse(world) * glm::vec4(camera.GetPosition(), 1.0f));
+        unsigned int lod = selectLod(mesh, handle, instance.node);
+        GLsizei indexCount = lod > 0 ? (GLsizei)mesh.lods[lod].indexCount : baseIndexCount;
+        size_t indexOffset = lod > 0 ? mesh.lods[lod].indexOffset : 0;
+        size_t indexSize = gpuMesh->indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+        
+        IndirectDrawData data;
+        std::memcpy(data.world, glm::value_ptr(world), sizeof(data.world));
+        glm::mat3x4 normalMatrix = packNormalMatrix(computeNormalMatrix(world));
+        std::memcpy(data.normalMatrix, glm::value_ptr(normalMatrix), sizeof(data.normalMatrix));
+        const QuantizationParams& q = gpuMesh->quantization;
+        for (int k = 0; k < 3; k++) {
+            data.positionOffset[k] = q.positionOffset[k];
+            data.positionScale[k] = q.positionScale[k];
+        }
+        data.positionOffset[3] = 0.0f;
+        data.positionScale[3] = 0.0f;
+        data.uvTransform[0] = q.uvOffset[0];
+        data.uvTransform[1] = q.uvOffset[1];
+        data.uvTransform[2] = q.uvScale[0];
+        data.uvTransform[3] = q.uvScale[1];
+        data.flags[0] = instance.mesh % MATERIAL_COUNT;
+        data.flags[1] = gpuMesh->format != VertexFormat::FLOAT32;
+        data.flags[2] = 0;
+        data.flags[3] = 0;
+        
+        // firstIndex - в индексах: смещение меша в общем буфере выровнено по размеру индекса
+        DrawElementsIndirectCommand command;
+        command.count = (GLuint)indexCount;
+        command.instanceCount = 1;
+        command.firstIndex = (GLuint)(gpuMesh->indexByteOffset / indexSize + indexOffset);
+        command.baseVertex = gpuMesh->baseVertex;
+        command.baseInstance = (GLuint)drawData.size();
+        
+        size_t batch = getBatchIndex(*gpuMesh);
+        indirectBatches[batch].push_back(command);
+        batchVertexArrays[batch] = gpuMesh->VAO;
+        drawData.push_back(data);
+        
+        renderStats.instancesDrawn++;
+        renderStats.trianglesDrawn += indexCount / 3;
+    }
+    if (drawData.empty()) return;
     
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, mesh.vertexBuffer.size() * sizeof(float), 
-                 mesh.vertexBuffer.data(), GL_STATIC_DRAW);
+    if (indirectBuffer == 0) {
+        glGenBuffers(1, &indirectBuffer);
+        glGenBuffers(1, &drawDataBuffer);
+        glGenBuffers(1, &materialBuffer);
+        glGenBuffers(1, &drawIndexBuffer);
+        
+        std::vector<glm::vec4> materials;
+        for (size_t i = 0; i < MATERIAL_COUNT; i++) materials.push_back(glm::vec4(MATERIAL_COLORS[i], 1.0f));
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, materialBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, materials.size() * sizeof(glm::vec4), materials.data(), GL_STATIC_DRAW);
+    }
     
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(unsigned int),
-                 mesh.indices.data(), GL_STATIC_DRAW);
+    // Атрибут drawIndex с делителем 1 читает drawIndexBuffer[baseInstance] - там просто 0, 1, 2...
+    if (drawIndexCapacity < drawData.size()) {
+        drawIndexCapacity = std::max(drawData.size(), drawIndexCapacity * 2);
+        std::vector<GLuint> drawIndices(drawIndexCapacity);
+        for (size_t i = 0; i < drawIndexCapacity; i++) drawIndices[i] = (GLuint)i;
+        glBindBuffer(GL_ARRAY_BUFFER, drawIndexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, drawIndices.size() * sizeof(GLuint), drawIndices.data(), GL_STATIC_DRAW);
+    }
     
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+    // Оба буфера переписываются каждый кадр - glBufferData отвязывает старое хранилище
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, drawDataBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, drawData.size() * sizeof(IndirectDrawData), drawData.data(), GL_STREAM_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, drawDataBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, materialBuffer);
     
-    glBindVertexArray(0);
+    indirectCommands.clear();
+    size_t batchStart[VERTEX_FORMAT_COUNT * 2];
+    for (size_t b = 0; b < VERTEX_FORMAT_COUNT * 2; b++) {
+        batchStart[b] = indirectCommands.size();
+        indirectCommands.insert(indirectCommands.end(), indirectBatches[b].begin(), indirectBatches[b].end());
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, indirectCommands.size() * sizeof(DrawElementsIndirectCommand),
+                 indirectCommands.data(), GL_STREAM_DRAW);
     
-    VAOs.push_back(VAO);
-    VBOs.push_back(VBO);
-    EBOs.push_back(EBO);
+    for (size_t b = 0; b < VERTEX_FORMAT_COUNT * 2; b++) {
+        if (indirectBatches[b].empty()) continue;
+        
+        glBindVertexArray(batchVertexArrays[b]);
+        renderStats.vertexArrayBinds++;
+        glBindBuffer(GL_ARRAY_BUFFER, drawIndexBuffer);
+        glVertexAttribIPointer(DRAW_INDEX_LOCATION, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)0);
+        glVertexAttribDivisor(DRAW_INDEX_LOCATION, 1);
+        glEnableVertexAttribArray(DRAW_INDEX_LOCATION);
+        
+        GLenum indexType = b % 2 ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+        glMultiDrawElementsIndirect(GL_TRIANGLES, indexType,
+                                    (void*)(batchStart[b] * sizeof(DrawElementsIndirectCommand)),
+                                    (GLsizei)indirectBatches[b].size(), 0);
+        glDisableVertexAttribArray(DRAW_INDEX_LOCATION);
+        renderStats.drawCalls++;
+    }
+    renderStats.indirectCommands = indirectCommands.size();
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void Renderer::uploadModel(const ModelParser& model) {
+    for (const auto& mesh : model.getMeshes()) {
+        meshCache.upload(mesh);
+    }
+    std::cout << "GPU resident meshes: " << meshCache.getMeshCount()
+              << " (" << meshCache.getResidentBytes() / 1024 << " KB)" << std::endl;
+    meshCache.printArenaReport();
+}
+
+void Renderer::evictModel(const ModelParser& model) {
+    std::unordered_set<MeshHandle> evicted;
+    for (const auto& mesh : model.getMeshes()) {
+        evicted.insert(meshCache.getHandle(mesh));
+        meshCache.evict(mesh);
+    }
+    for (auto it = lodState.begin(); it != lodState.end();) {
+        if (evicted.count((MeshHandle)(it->first >> 32))) it = lodState.erase(it);
+        else ++it;
+    }
+}
+
+const GpuMesh* Renderer::residentMesh(const StandardMesh& mesh, MeshHandle& handle) {
+    handle = meshCache.getHandle(mesh);
+    if (handle == INVALID_MESH_HANDLE) {
+        if (mesh.vertexCount() == 0 || mesh.indexCount() == 0) return nullptr;
+        handle = meshCache.upload(mesh);
+        // Загрузка посреди кадра могла сменить текущий VAO
+        boundVertexArray = 0;
+    }
+    return meshCache.get(handle);
+}
+
+const GpuMesh* Renderer::bindMesh(const StandardMesh& mesh, MeshHandle& handle) {
+    const GpuMesh* gpuMesh = residentMesh(mesh, handle);
+    if (!gpuMesh) return nullptr;
     
-    return VAO;
+    if (gpuMesh->VAO != boundVertexArray) {
+        glBindVertexArray(gpuMesh->VAO);
+        boundVertexArray = gpuMesh->VAO;
+        renderStats.vertexArrayBinds++;
+    }
+    return gpuMesh;
 }
 
-void Renderer::renderStandardMesh(const StandardMesh& mesh, GLuint shaderProgram) {
-    GLuint VAO = createMeshBuffers(mesh);
+void Renderer::renderStandardMesh(const StandardMesh& mesh, uint32_t node) {
+    MeshHandle handle;
+    const GpuMesh* gpuMesh = bindMesh(mesh, handle);
+    if (!gpuMesh) return;
     
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, mesh.indices.size(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    size_t indexSize = gpuMesh->indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+    GLsizei baseIndexCount = mesh.lods.empty() ? gpuMesh->indexCount : (GLsizei)mesh.lods[0].indexCount;
+    renderStats.fullDetailTriangles += baseIndexCount / 3;
+    
+    unsigned int lod = selectLod(mesh, handle, node);
+    if (lod > 0) {
+        const MeshLod& level = mesh.lods[lod];
+        glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)level.indexCount, gpuMesh->indexType,
+                                 (void*)(gpuMesh->indexByteOffset + level.indexOffset * indexSize), gpuMesh->baseVertex);
+        renderStats.drawCalls++;
+        renderStats.trianglesDrawn += level.indexCount / 3;
+        return;
+    }
+    
+    // Кластеры скинированного меша посчитаны в bind-позе - отсекать по ним нельзя
+    size_t meshletCount = mesh.meshletCount();
+    if (!clusterCulling || meshletCount == 0 || !mesh.skin.empty()) {
+        glDrawElementsBaseVertex(GL_TRIANGLES, baseIndexCount, gpuMesh->indexType,
+                                 (void*)gpuMesh->indexByteOffset, gpuMesh->baseVertex);
+        renderStats.drawCalls++;
+        renderStats.trianglesDrawn += baseIndexCount / 3;
+        return;
+    }
+    
+    // Соседние видимые кластеры сливаются в один диапазон индексов
+    const Meshlet* meshlets = mesh.meshletData();
+    const float* cameraPosition = &modelCameraPosition.x;
+    size_t rangeStart = 0, rangeCount = 0;
+    
+    for (size_t i = 0; i < meshletCount; i++) {
+        const Meshlet& meshlet = meshlets[i];
+        renderStats.totalClusters++;
+        
+        bool visible = coneCulling
+            ? MeshletBuilder::isVisible(meshlet, modelFrustum, cameraPosition)
+            : modelFrustum.intersectsSphere(meshlet.center, meshlet.radius);
+        
+        if (visible) {
+            renderStats.visibleClusters++;
+            if (rangeCount > 0 && rangeStart + rangeCount == meshlet.indexOffset) {
+                rangeCount += meshlet.triangleCount * 3;
+                continue;
+            }
+        }
+        
+        if (rangeCount > 0) {
+            glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)rangeCount, gpuMesh->indexType,
+                                     (void*)(gpuMesh->indexByteOffset + rangeStart * indexSize), gpuMesh->baseVertex);
+            renderStats.drawCalls++;
+            renderStats.trianglesDrawn += rangeCount / 3;
+            rangeCount = 0;
+        }
+        if (visible) {
+            rangeStart = meshlet.indexOffset;
+            rangeCount = meshlet.triangleCount * 3;
+        }
+    }
+    
+    if (rangeCount > 0) {
+        glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)rangeCount, gpuMesh->indexType,
+                                 (void*)(gpuMesh->indexByteOffset + rangeStart * indexSize), gpuMesh->baseVertex);
+        renderStats.drawCalls++;
+        renderStats.trianglesDrawn += rangeCount / 3;
+    }
 }
 
-GLuint compileShader(const char* source, GLenum type) {
-    GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &source, nullptr);
-    glCompileShader(shader);
+void Renderer::renderInstancedMesh(const StandardMesh& mesh, const SceneGraph& sceneGraph,
+                                   const MeshInstance* instances, size_t count,
+                                   const glm::mat4& modelMatrix, const Frustum& sceneFrustum) {
+    MeshHandle handle;
+    const GpuMesh* gpuMesh = bindMesh(mesh, handle);
+    if (!gpuMesh) return;
+    
+    glm::vec4 center(mesh.bounds.center[0], mesh.bounds.center[1], mesh.bounds.center[2], 1.0f);
+    float radius = mesh.bounds.radius;
+    glm::vec3 sceneCamera = glm::vec3(glm::inverse(modelMatrix) * glm::vec4(camera.GetPosition(), 1.0f));
+    
+    // Экземпляры отсекаются целиком по сфере меша; LOD выбирается по экземпляру,
+    // которому нужна наибольшая детализация
+    instanceTransforms.clear();
+    const glm::mat4* detailTransform = nullptr;
+    float maxDetail = -1.0f;
+    for (size_t i = 0; i < count; i++) {
+        const glm::mat4& world = sceneGraph.getWorldTransform(instances[i].node);
+        glm::vec3 worldCenter = glm::vec3(world * center);
+        float scale = std::max(glm::length(glm::vec3(world[0])),
+                               std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+        float worldRadius = radius * scale;
+        if (clusterCulling && mesh.skin.empty() && !sceneFrustum.intersectsSphere(&worldCenter.x, worldRadius)) continue;
+        
+        InstanceTransform transform = {world, packNormalMatrix(computeNormalMatrix(world))};
+        instanceTransforms.push_back(transform);
+        float distance = glm::length(sceneCamera - worldCenter) - worldRadius;
+        float detail = distance > 0.0f ? scale / distance : std::numeric_limits<float>::max();
+        if (detail > maxDetail) {
+            maxDetail = detail;
+            detailTransform = &world;
+        }
+    }
+    
+    GLsizei baseIndexCount = mesh.lods.empty() ? gpuMesh->indexCount : (GLsizei)mesh.lods[0].indexCount;
+    renderStats.fullDetailTriangles += (size_t)(baseIndexCount / 3) * count;
+    if (instanceTransforms.empty()) return;
     
-    int success;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
-        std::cout << "Shader compilation failed: " << infoLog << std::endl;
+    modelCameraPosition = glm::vec3(glm::inverse(modelMatrix * *detailTransform) * glm::vec4(camera.GetPosition(), 1.0f));
+    unsigned int lod = selectLod(mesh, handle, INSTANCE_GROUP_NODE);
+    GLsizei indexCount = lod > 0 ? (GLsizei)mesh.lods[lod].indexCount : baseIndexCount;
+    size_t indexOffset = lod > 0 ? mesh.lods[lod].indexOffset : 0;
+    size_t indexSize = gpuMesh->indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+    
+    // Буфер переписывается каждый кадр - glBufferData отвязывает старое хранилище
+    if (instanceBuffer == 0) {
+        glGenBuffers(1, &instanceBuffer);
     }
-    return shader;
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, instanceTransforms.size() * sizeof(InstanceTransform),
+                 instanceTransforms.data(), GL_STREAM_DRAW);
+    bindInstanceTransforms(instanceBuffer, 0);
+    
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, indexCount, gpuMesh->indexType,
+                                      (void*)(gpuMesh->indexByteOffset + indexOffset * indexSize),
+                                      (GLsizei)instanceTransforms.size(), gpuMesh->baseVertex);
+    
+    unbindInstanceTransforms();
+    // После вызова с включёнными массивами текущее значение атрибутов не определено
+    setConstantInstanceTransform(IDENTITY_INSTANCE);
+    
+    renderStats.drawCalls++;
+    renderStats.instancesDrawn += instanceTransforms.size();
+    renderStats.trianglesDrawn += (size_t)(indexCount / 3) * instanceTransforms.size();
 }
 
-GLuint initShaders() {
-    GLuint vertexShader = compileShader(vertexShaderSource, GL_VERTEX_SHADER);
-    GLuint fragmentShader = compileShader(fragmentShaderSource, GL_FRAGMENT_SHADER);
+unsigned int Renderer::selectLod(const StandardMesh& mesh, MeshHandle handle, uint32_t node) {
+    if (!lodSelection || mesh.lods.size() < 2) return 0;
     
-    GLuint program = glCreateProgram();
-    glAttachShader(program, vertexShader);
-    glAttachShader(program, fragmentShader);
-    glLinkProgram(program);
+    // Размещения одного меша на разных расстояниях держат каждое свой уровень
+    uint64_t key = ((uint64_t)handle << 32) | node;    
+    glm::vec3 center(mesh.bounds.center[0], mesh.bounds.center[1], mesh.bounds.center[2]);
+    float radius = mesh.bounds.radius;
     
-    int success;
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetProgramInfoLog(program, 512, nullptr, infoLog);
-        std::cout << "Program linking failed: " << infoLog << std::endl;
+    // Внутри сферы меша - всегда полная детализация
+    float distance = glm::length(modelCameraPosition - center) - radius;
+    if (distance <= 0.0f) {
+        lodState[key] = 0;
+        return 0;
     }
+    float pixelsPerUnit = lodPixelScale / distance;
     
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    unsigned int current = 0;
+    auto it = lodState.find(key);
+    if (it != lodState.end()) current = std::min(it->second, (unsigned int)mesh.lods.size() - 1);
     
-    return program;
-}
\ No newline at end of file
+    unsigned int desired = 0;
+    for (unsigned int i = 1; i < mesh.lods.size(); i++) {
+        if (mesh.lods[i].error * pixelsPerUnit <= lodErrorThreshold) desired = i;
+    }
+    
+    // Огрубляем только с запасом, чтобы уровень не дрожал на границе порога
+    float coarserThreshold = lodErrorThreshold * (1.0f - lodHysteresis);
+    while (desired > current && mesh.lods[desired].error * pixelsPerUnit > coarserThreshold) {
+        desired--;
+    }
+    
+    lodState[key] = desired;
+    return desired;
+}
@@ -5,6 +5,80 @@
 #include <GLFW/glfw3.h>
 #include "parser.h"
 #include "camera.h"
+#include "gpumesh.h"
+#include "frustum.h"
+#include "shaderprogram.h"
+#include "uniformbuffer.h"
+
+struct RenderStats {
+    size_t totalClusters;
+    size_t visibleClusters;
+    size_t drawCalls;
+    size_t trianglesDrawn;
+    size_t fullDetailTriangles;
+    size_t instancesDrawn;
+    size_t vertexArrayBinds; // VAO общие на формат - смена только при смене формата
+    size_t indirectCommands; // 0 - кадр нарисован по вызову на меш
+    size_t uniformBlocks;    // блоков в кольце UBO за кадр
+    size_t uniformBytes;
+    double submitMs;         // CPU-время отправки сцены
+};
+
+// GPU-время отправки сцены: запросы GL_TIME_ELAPSED по кругу, результат запроса
+// читается через TIMER_QUERY_COUNT кадров, когда GPU его уже посчитал
+const size_t TIMER_QUERY_COUNT = 3;
+
+// Точки привязки uniform-блоков; раскладки - std140, совпадают с блоками в шейдерах
+const GLuint FRAME_UNIFORM_BINDING = 0;
+const GLuint LIGHT_UNIFORM_BINDING = 1;
+const GLuint OBJECT_UNIFORM_BINDING = 2;
+const size_t UNIFORM_RING_REGION_BYTES = 256 * 1024;
+
+struct FrameUniforms {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 cameraPosition; // w - время
+};
+
+struct LightUniforms {
+    glm::vec4 position;
+    glm::vec4 color;
+};
+
+struct ObjectUniforms {
+    glm::mat4 model;
+    glm::mat3x4 normalMatrix; // mat3 в std140 - столбцы vec4
+    glm::vec4 color;
+    glm::vec4 positionOffset;
+    glm::vec4 positionScale;
+    glm::vec4 uvTransform; // смещение UV, масштаб UV
+    glm::uvec4 flags;      // октаэдрические нормали
+};
+
+static_assert(sizeof(FrameUniforms) == 144, "FrameUniforms must match std140 layout");
+static_assert(sizeof(LightUniforms) == 32, "LightUniforms must match std140 layout");
+static_assert(sizeof(ObjectUniforms) == 192, "ObjectUniforms must match std140 layout");
+
+// Раскладка команды glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// Данные отрисовки в SSBO, std430 - совпадает с DrawData в шейдере
+struct IndirectDrawData {
+    float world[16];
+    float normalMatrix[12]; // mat3 - три столбца vec4
+    float positionOffset[4];
+    float positionScale[4];
+    float uvTransform[4]; // смещение UV, масштаб UV
+    uint32_t flags[4];    // материал, октаэдрические нормали
+};
+
+static_assert(sizeof(IndirectDrawData) == 176, "IndirectDrawData must match std430 layout");
 
 class Renderer {
 public:
@@ -16,7 +90,9 @@ public:
     bool shouldClose() const { return glfwWindowShouldClose(window); }
     void beginFrame();
     void endFrame();
-    void renderModel(const ModelParser& model, GLuint shaderProgram);
+    void renderModel(const ModelParser& model);
+    void uploadModel(const ModelParser& model);
+    void evictModel(const ModelParser& model);
     
     void processInput(float deltaTime);
     void mouseCallback(double xpos, double ypos);
@@ -24,6 +100,8 @@ public:
     
     GLFWwindow* getWindow() const { return window; }
     Camera& getCamera() { return camera; }
+    GpuMeshCache& getMeshCache() { return meshCache; }
+    void setVertexFormat(VertexFormat format) { meshCache.setVertexFormat(format); }
     
     void setAnimateModel(bool animate) { animateModel = animate; }
     bool getAnimateModel() const { return animateModel; }
@@ -32,14 +110,65 @@ public:
     void setSprintEnabled(bool enabled) { sprintEnabled = enabled; }
     bool getSprintEnabled() const { return sprintEnabled; }
     void toggleSprint() { sprintEnabled = !sprintEnabled; }
+    
+    void setClusterCulling(bool enabled) { clusterCulling = enabled; }
+    bool getClusterCulling() const { return clusterCulling; }
+    const RenderStats& getRenderStats() const { return renderStats; }
+    
+    // Порог ошибки LOD в пикселях; hysteresis - доля порога, на которую нужно
+    // опуститься ниже него, чтобы перейти на более грубый уровень
+    void setLodSelection(bool enabled) { lodSelection = enabled; }
+    bool getLodSelection() const { return lodSelection; }
+    void setLodErrorThreshold(float pixels) { lodErrorThreshold = pixels; }
+    void setLodHysteresis(float fraction) { lodHysteresis = fraction; }
+    
+    // Меш, стоящий в нескольких узлах, рисуется одним glDrawElementsInstanced
+    void setInstancing(bool enabled) { instancing = enabled; }
+    bool getInstancing() const { return instancing; }
+    
+    // Вся сцена одним glMultiDrawElementsIndirect на пакет; без GL 4.3 - вызов на меш
+    void setMultiDraw(bool enabled) { multiDraw = enabled; }
+    bool getMultiDraw() const { return multiDraw; }
+    bool isMultiDrawSupported() const { return multiDrawSupported; }
+    
+    // false - матрица нормалей обращается в вершинном шейдере, как раньше; только для
+    // сравнения пропускной способности вершин в статистике GPU
+    void setCpuNormalMatrix(bool enabled);
+    bool getCpuNormalMatrix() const { return cpuNormalMatrix; }
 
 private:
-    void renderStandardMesh(const StandardMesh& mesh, GLuint shaderProgram);
-    GLuint createMeshBuffers(const StandardMesh& mesh);
+    // Объект прохода по вызову на меш: экземпляры [begin, end) и его блок в кольце
+    struct ObjectDraw {
+        uint32_t mesh;
+        size_t begin;
+        size_t end;
+        size_t uniformOffset;
+    };
+    
+    static bool bindUniformBlocks(ShaderProgram& program);
+    void updateLight(const glm::vec3& position, const glm::vec3& color);
+    const GpuMesh* residentMesh(const StandardMesh& mesh, MeshHandle& handle);
+    const GpuMesh* bindMesh(const StandardMesh& mesh, MeshHandle& handle);
+    void renderStandardMesh(const StandardMesh& mesh, uint32_t node);
+    void renderInstancedMesh(const StandardMesh& mesh, const SceneGraph& sceneGraph,
+                             const MeshInstance* instances, size_t count,
+                             const glm::mat4& modelMatrix, const Frustum& sceneFrustum);
+    void renderIndirect(const ModelParser& model, const glm::mat4& modelMatrix, const Frustum& sceneFrustum);
+    unsigned int selectLod(const StandardMesh& mesh, MeshHandle handle, uint32_t node);
+    ShaderProgram& currentProgram(bool indirect);
+    void beginGpuTimer();
+    void endGpuTimer(size_t vertices);
     
     GLFWwindow* window;
     Camera camera;
     
+    ShaderProgram sceneProgram;
+    UniformRingBuffer uniformRing;
+    GLuint lightBuffer;
+    LightUniforms lightUniforms;
+    bool lightValid;
+    std::vector<ObjectDraw> objectDraws;
+    
     float lastX, lastY;
     bool firstMouse;
     
@@ -49,12 +178,52 @@ private:
     bool animateModel;
     bool sprintEnabled;
     
-    std::vector<GLuint> VAOs;
-    std::vector<GLuint> VBOs;
-    std::vector<GLuint> EBOs;
+    // Отсечение кластеров: фрустум и камера в пространстве текущей модели
+    bool clusterCulling;
+    bool coneCulling;
+    Frustum modelFrustum;
+    glm::vec3 modelCameraPosition;
+    RenderStats renderStats;
+    GLuint boundVertexArray;
+    
+    bool lodSelection;
+    float lodErrorThreshold;
+    float lodHysteresis;
+    float lodPixelScale;
+    // Уровень по размещению: handle в старших 32 битах, узел - в младших
+    std::unordered_map<uint64_t, unsigned int> lodState;
+    
+    bool instancing;
+    GLuint instanceBuffer;
+    std::vector<InstanceTransform> instanceTransforms;
+    
+    bool multiDrawSupported;
+    bool multiDraw;
+    ShaderProgram indirectProgram;
+    GLuint indirectBuffer;
+    GLuint drawDataBuffer;
+    GLuint materialBuffer;
+    GLuint drawIndexBuffer; // 0, 1, 2... - индекс отрисовки через baseInstance
+    size_t drawIndexCapacity;
+    std::vector<IndirectDrawData> drawData;
+    // Пакеты по формату вершин и типу индексов
+    std::vector<DrawElementsIndirectCommand> indirectBatches[VERTEX_FORMAT_COUNT * 2];
+    GLuint batchVertexArrays[VERTEX_FORMAT_COUNT * 2];
+    std::vector<DrawElementsIndirectCommand> indirectCommands;
+    
+    // Те же программы с inverse() в шейдере - точка сравнения для замера
+    bool cpuNormalMatrix;
+    ShaderProgram referenceSceneProgram;
+    ShaderProgram referenceIndirectProgram;
+    
+    GLuint timerQueries[TIMER_QUERY_COUNT];
+    size_t timerVertices[TIMER_QUERY_COUNT]; // вершины кадра запроса; 0 - запрос не запущен
+    size_t timerFrame;
+    double gpuTimeMs;       // сумма с последнего вывода статистики
+    size_t gpuTimedVertices;
+    size_t gpuTimedFrames;
+    
+    GpuMeshCache meshCache;
 };
 
-GLuint compileShader(const char* source, GLenum type);
-GLuint initShaders();
-
 #endif
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include "scenegraph.h"
+#include <iostream>
+#include <algorithm>
+
+uint32_t SceneGraph::addNode(int parent, const glm::mat4& local, const std::string& name) {
+    uint32_t node = (uint32_t)parents.size();
+    // Порядок обхода в глубину: родителем может быть только узел, чьё поддерево ещё открыто
+    if (parent != SCENE_NO_PARENT && (parent >= (int)node || subtreeEnd[parent] != node)) {
+        std::cout << "SceneGraph: node '" << name << "' added out of depth-first order, attached to root" << std::endl;
+        parent = SCENE_NO_PARENT;
+    }
+
+    parents.push_back(parent);
+    subtreeEnd.push_back(node + 1);
+    localTransforms.push_back(local);
+    worldTransforms.push_back(local);
+    dirty.push_back(1);
+    names.push_back(name);
+
+    // Новый узел расширяет поддеревья всех своих предков
+    for (int ancestor = parent; ancestor != SCENE_NO_PARENT; ancestor = parents[ancestor]) {
+        subtreeEnd[ancestor] = node + 1;
+    }
+    return node;
+}
+
+void SceneGraph::addMeshInstance(uint32_t node, uint32_t mesh) {
+    MeshInstance instance = {node, mesh};
+    instances.push_back(instance);
+}
+
+void SceneGraph::sortInstancesByMesh() {
+    std::stable_sort(instances.begin(), instances.end(), [](const MeshInstance& a, const MeshInstance& b) {
+        return a.mesh < b.mesh;
+    });
+}
+
+void SceneGraph::clear() {
+    parents.clear();
+    subtreeEnd.clear();
+    localTransforms.clear();
+    worldTransforms.clear();
+    dirty.clear();
+    names.clear();
+    instances.clear();
+}
+
+void SceneGraph::setLocalTransform(uint32_t node, const glm::mat4& local) {
+    localTransforms[node] = local;
+    dirty[node] = 1;
+}
+
+size_t SceneGraph::updateWorldTransforms() {
+    size_t updated = 0;
+    size_t count = parents.size();
+
+    for (size_t i = 0; i < count;) {
+        if (!dirty[i]) {
+            i++;
+            continue;
+        }
+
+        // Всё поддерево грязного узла пересчитывается подряд: родитель уже готов
+        size_t end = subtreeEnd[i];
+        for (size_t j = i; j < end; j++) {
+            int parent = parents[j];
+            worldTransforms[j] = parent == SCENE_NO_PARENT
+                ? localTransforms[j]
+                : worldTransforms[parent] * localTransforms[j];
+            dirty[j] = 0;
+        }
+        updated += end - i;
+        i = end;
+    }
+    return updated;
+}
+
+int SceneGraph::findNode(const std::string& name) const {
+    for (size_t i = 0; i < names.size(); i++) {
+        if (names[i] == name) return (int)i;
+    }
+    return SCENE_NO_PARENT;
+}
@@ -0,0 +1,56 @@
+#ifndef SCENEGRAPH_H
+#define SCENEGRAPH_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+const int SCENE_NO_PARENT = -1;
+
+// Узел, на который ссылается меш: один меш может стоять в нескольких узлах
+struct MeshInstance {
+    uint32_t node;
+    uint32_t mesh;
+};
+
+// Иерархия узлов в плоских массивах (SoA) в порядке обхода в глубину:
+// родитель всегда раньше потомков, поддерево узла i - диапазон [i, subtreeEnd[i]).
+// Поэтому мировые матрицы пересчитываются одним линейным проходом,
+// а грязный флаг пересчитывает только изменённые поддеревья.
+class SceneGraph {
+public:
+    // Узлы добавляются в порядке обхода в глубину: parent - уже добавленный узел
+    // на текущей цепочке предков (или SCENE_NO_PARENT)
+    uint32_t addNode(int parent, const glm::mat4& local, const std::string& name = std::string());
+    void addMeshInstance(uint32_t node, uint32_t mesh);
+    // Группирует экземпляры одного меша подряд - рендерер рисует такую группу одним вызовом
+    void sortInstancesByMesh();
+    void clear();
+
+    void setLocalTransform(uint32_t node, const glm::mat4& local);
+    const glm::mat4& getLocalTransform(uint32_t node) const { return localTransforms[node]; }
+    const glm::mat4& getWorldTransform(uint32_t node) const { return worldTransforms[node]; }
+
+    // Пересчитывает мировые матрицы грязных поддеревьев, возвращает число обновлённых узлов
+    size_t updateWorldTransforms();
+
+    int findNode(const std::string& name) const;
+
+    size_t getNodeCount() const { return parents.size(); }
+    int getParent(uint32_t node) const { return parents[node]; }
+    uint32_t getSubtreeEnd(uint32_t node) const { return subtreeEnd[node]; }
+    const std::string& getName(uint32_t node) const { return names[node]; }
+    const std::vector<MeshInstance>& getMeshInstances() const { return instances; }
+
+private:
+    std::vector<int> parents;
+    std::vector<uint32_t> subtreeEnd;
+    std::vector<glm::mat4> localTransforms;
+    std::vector<glm::mat4> worldTransforms;
+    std::vector<uint8_t> dirty;
+    std::vector<std::string> names;
+    std::vector<MeshInstance> instances;
+};
+
+#endif
@@ -0,0 +1,202 @@
+#include "shaderprogram.h"
+#include <iostream>
+#include <cstring>
+
+// Самый крупный поддерживаемый тип - mat4
+const size_t UNIFORM_CACHE_SLOT_SIZE = sizeof(glm::mat4);
+
+GLuint ShaderProgram::currentProgram = 0;
+
+ShaderProgram::ShaderProgram() : program(0), uploads(0), skipped(0) {}
+
+static GLuint compileShader(const std::string& programName, const char* source, GLenum type) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    int success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
+        std::cout << "Shader compilation failed (" << programName << ", "
+                  << (type == GL_VERTEX_SHADER ? "vertex" : "fragment") << "): " << infoLog << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+bool ShaderProgram::build(const std::string& programName, const char* vertexSource, const char* fragmentSource) {
+    destroy();
+    name = programName;
+
+    GLuint vertexShader = compileShader(name, vertexSource, GL_VERTEX_SHADER);
+    GLuint fragmentShader = compileShader(name, fragmentSource, GL_FRAGMENT_SHADER);
+    if (!vertexShader || !fragmentShader) {
+        if (vertexShader) glDeleteShader(vertexShader);
+        if (fragmentShader) glDeleteShader(fragmentShader);
+        return false;
+    }
+
+    program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetProgramInfoLog(program, 512, nullptr, infoLog);
+        std::cout << "Program linking failed (" << name << "): " << infoLog << std::endl;
+        glDeleteProgram(program);
+        program = 0;
+        return false;
+    }
+
+    reflect();
+    return true;
+}
+
+void ShaderProgram::destroy() {
+    if (program != 0) {
+        if (currentProgram == program) currentProgram = 0;
+        glDeleteProgram(program);
+        program = 0;
+    }
+    uniforms.clear();
+    attributes.clear();
+    uniformBlocks.clear();
+    cacheSlots.clear();
+    cache.clear();
+    resetUploadCounters();
+}
+
+void ShaderProgram::use() {
+    if (currentProgram == program) return;
+    glUseProgram(program);
+    currentProgram = program;
+}
+
+static std::string stripArraySuffix(const char* name) {
+    std::string result(name);
+    size_t bracket = result.find('[');
+    if (bracket != std::string::npos) result.resize(bracket);
+    return result;
+}
+
+void ShaderProgram::reflect() {
+    GLint count = 0, maxLength = 0;
+    std::vector<char> buffer;
+
+    // Члены uniform-блоков не имеют location - они задаются через буфер, не здесь
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    buffer.resize(maxLength + 1);
+    for (GLint i = 0; i < count; i++) {
+        ActiveVariable variable;
+        GLsizei length = 0;
+        glGetActiveUniform(program, (GLuint)i, (GLsizei)buffer.size(), &length, &variable.size, &variable.type, buffer.data());
+        variable.location = glGetUniformLocation(program, buffer.data());
+        if (variable.location < 0) continue;
+        variable.name = stripArraySuffix(buffer.data());
+
+        CacheSlot slot = {cache.size(), UNIFORM_CACHE_SLOT_SIZE, false};
+        cache.resize(cache.size() + UNIFORM_CACHE_SLOT_SIZE);
+        cacheSlots.push_back(slot);
+        uniforms.push_back(variable);
+    }
+
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+    buffer.resize(maxLength + 1);
+    for (GLint i = 0; i < count; i++) {
+        ActiveVariable variable;
+        GLsizei length = 0;
+        glGetActiveAttrib(program, (GLuint)i, (GLsizei)buffer.size(), &length, &variable.size, &variable.type, buffer.data());
+        variable.location = glGetAttribLocation(program, buffer.data());
+        variable.name = stripArraySuffix(buffer.data());
+        attributes.push_back(variable);
+    }
+
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+    buffer.resize(maxLength + 1);
+    for (GLint i = 0; i < count; i++) {
+        ActiveVariable block;
+        GLsizei length = 0;
+        glGetActiveUniformBlockName(program, (GLuint)i, (GLsizei)buffer.size(), &length, buffer.data());
+        glGetActiveUniformBlockiv(program, (GLuint)i, GL_UNIFORM_BLOCK_DATA_SIZE, &block.size);
+        block.name = buffer.data();
+        block.location = i;
+        block.type = GL_UNIFORM_BLOCK;
+        uniformBlocks.push_back(block);
+    }
+}
+
+bool ShaderProgram::bindUniformBlock(const char* blockName, GLuint binding, size_t expectedSize) {
+    for (const ActiveVariable& block : uniformBlocks) {
+        if (block.name != blockName) continue;
+        if ((size_t)block.size != expectedSize) {
+            std::cout << "Uniform block " << blockName << " in " << name << " is " << block.size
+                      << " bytes, expected " << expectedSize << std::endl;
+            return false;
+        }
+        glUniformBlockBinding(program, (GLuint)block.location, binding);
+        return true;
+    }
+    return true;
+}
+
+int ShaderProgram::findUniform(const char* uniformName) const {
+    for (size_t i = 0; i < uniforms.size(); i++) {
+        if (uniforms[i].name == uniformName) return (int)i;
+    }
+    return -1;
+}
+
+void ShaderProgram::reportTypeMismatch(const char* uniformName) const {
+    std::cout << "Uniform " << uniformName << " in " << name << " has a different GLSL type, ignored" << std::endl;
+}
+
+GLint ShaderProgram::getAttributeLocation(const char* attributeName) const {
+    for (const ActiveVariable& attribute : attributes) {
+        if (attribute.name == attributeName) return attribute.location;
+    }
+    return -1;
+}
+
+bool ShaderProgram::updateCache(int slot, const void* value, size_t size) {
+    CacheSlot& cached = cacheSlots[slot];
+    if (size > cached.size) return true;
+    unsigned char* stored = cache.data() + cached.offset;
+    if (cached.hasValue && std::memcmp(stored, value, size) == 0) {
+        skipped++;
+        return false;
+    }
+    std::memcpy(stored, value, size);
+    cached.hasValue = true;
+    uploads++;
+    return true;
+}
+
+void ShaderProgram::printReflection() const {
+    std::cout << "Shader program " << name << ": " << uniforms.size() << " uniforms, "
+              << attributes.size() << " attributes, " << uniformBlocks.size() << " uniform blocks" << std::endl;
+    for (const ActiveVariable& uniform : uniforms) {
+        std::cout << "  uniform " << uniform.name << " @" << uniform.location
+                  << " type 0x" << std::hex << uniform.type << std::dec;
+        if (uniform.size > 1) std::cout << " [" << uniform.size << "]";
+        std::cout << std::endl;
+    }
+    for (const ActiveVariable& attribute : attributes) {
+        std::cout << "  in " << attribute.name << " @" << attribute.location
+                  << " type 0x" << std::hex << attribute.type << std::dec << std::endl;
+    }
+    for (const ActiveVariable& block : uniformBlocks) {
+        std::cout << "  block " << block.name << " " << block.size << " bytes" << std::endl;
+    }
+}
@@ -0,0 +1,138 @@
+#ifndef SHADERPROGRAM_H
+#define SHADERPROGRAM_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// Загрузка значения униформа по типу C++; accepts - совместимые типы GLSL
+template <typename T> struct UniformTraits;
+
+template <> struct UniformTraits<float> {
+    static bool accepts(GLenum type) { return type == GL_FLOAT; }
+    static void upload(GLint location, const float& value) { glUniform1f(location, value); }
+};
+template <> struct UniformTraits<int> {
+    static bool accepts(GLenum type) { return type == GL_INT || type == GL_SAMPLER_2D; }
+    static void upload(GLint location, const int& value) { glUniform1i(location, value); }
+};
+template <> struct UniformTraits<bool> {
+    static bool accepts(GLenum type) { return type == GL_BOOL; }
+    static void upload(GLint location, const bool& value) { glUniform1i(location, value ? 1 : 0); }
+};
+template <> struct UniformTraits<glm::vec2> {
+    static bool accepts(GLenum type) { return type == GL_FLOAT_VEC2; }
+    static void upload(GLint location, const glm::vec2& value) { glUniform2fv(location, 1, glm::value_ptr(value)); }
+};
+template <> struct UniformTraits<glm::vec3> {
+    static bool accepts(GLenum type) { return type == GL_FLOAT_VEC3; }
+    static void upload(GLint location, const glm::vec3& value) { glUniform3fv(location, 1, glm::value_ptr(value)); }
+};
+template <> struct UniformTraits<glm::vec4> {
+    static bool accepts(GLenum type) { return type == GL_FLOAT_VEC4; }
+    static void upload(GLint location, const glm::vec4& value) { glUniform4fv(location, 1, glm::value_ptr(value)); }
+};
+template <> struct UniformTraits<glm::mat4> {
+    static bool accepts(GLenum type) { return type == GL_FLOAT_MAT4; }
+    static void upload(GLint location, const glm::mat4& value) { glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value)); }
+};
+
+// Handle униформа, найденного при разборе программы; slot < 0 - униформа нет
+// (не объявлен или выброшен компилятором), запись в него ничего не делает
+template <typename T>
+struct ShaderUniform {
+    int slot;
+    bool isValid() const { return slot >= 0; }
+};
+
+// Программа из вершинного и фрагментного шейдера. После линковки активные униформы
+// и атрибуты разбираются один раз; значения униформов кэшируются, и повторная
+// запись того же значения не доходит до GL.
+class ShaderProgram {
+public:
+    struct ActiveVariable {
+        std::string name; // у массивов без "[0]"
+        GLint location;
+        GLenum type;
+        GLint size;
+    };
+
+    ShaderProgram();
+    ShaderProgram(const ShaderProgram&) = delete;
+    ShaderProgram& operator=(const ShaderProgram&) = delete;
+
+    bool build(const std::string& name, const char* vertexSource, const char* fragmentSource);
+    // Удаляет программу - вызывается при живом контексте
+    void destroy();
+
+    bool isValid() const { return program != 0; }
+    GLuint getId() const { return program; }
+    const std::string& getName() const { return name; }
+
+    // glUseProgram только при смене программы
+    void use();
+
+    // Типизированный handle; тип GLSL сверяется с T
+    template <typename T>
+    ShaderUniform<T> uniform(const char* uniformName) const {
+        ShaderUniform<T> handle = {findUniform(uniformName)};
+        if (handle.slot >= 0 && !UniformTraits<T>::accepts(uniforms[handle.slot].type)) {
+            reportTypeMismatch(uniformName);
+            handle.slot = -1;
+        }
+        return handle;
+    }
+
+    // Программа должна быть текущей (use)
+    template <typename T>
+    void set(ShaderUniform<T> handle, const T& value) {
+        if (handle.slot < 0 || !updateCache(handle.slot, &value, sizeof(T))) return;
+        UniformTraits<T>::upload(uniforms[handle.slot].location, value);
+    }
+
+    // Привязка uniform-блока к точке glBindBufferRange; размер блока std140 сверяется
+    // с C++-структурой. Блока нет в программе - true: писать в него некому
+    bool bindUniformBlock(const char* blockName, GLuint binding, size_t expectedSize);
+
+    const std::vector<ActiveVariable>& getUniforms() const { return uniforms; }
+    const std::vector<ActiveVariable>& getAttributes() const { return attributes; }
+    // location - индекс блока, size - размер данных в байтах
+    const std::vector<ActiveVariable>& getUniformBlocks() const { return uniformBlocks; }
+    GLint getAttributeLocation(const char* attributeName) const;
+    void printReflection() const;
+
+    // Записи униформов, дошедшие до GL и отброшенные кэшем
+    size_t getUploadCount() const { return uploads; }
+    size_t getSkippedCount() const { return skipped; }
+    void resetUploadCounters() { uploads = skipped = 0; }
+
+private:
+    struct CacheSlot {
+        size_t offset;
+        size_t size;
+        bool hasValue;
+    };
+
+    void reflect();
+    int findUniform(const char* uniformName) const;
+    void reportTypeMismatch(const char* uniformName) const;
+    // false - значение совпало с последним записанным
+    bool updateCache(int slot, const void* value, size_t size);
+
+    GLuint program;
+    std::string name;
+    std::vector<ActiveVariable> uniforms;
+    std::vector<ActiveVariable> attributes;
+    std::vector<ActiveVariable> uniformBlocks;
+    std::vector<CacheSlot> cacheSlots; // параллельно uniforms
+    std::vector<unsigned char> cache;
+    size_t uploads;
+    size_t skipped;
+
+    static GLuint currentProgram;
+};
+
+#endif
@@ -0,0 +1,252 @@
+#include "simplify.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+struct Quadric {
+    // Симметричная 4x4: a00 a01 a02 a03 a11 a12 a13 a22 a23 a33
+    double a[10];
+    double weight;
+};
+
+static void addPlane(Quadric& q, const double n[3], double d, double w) {
+    q.a[0] += w * n[0] * n[0]; q.a[1] += w * n[0] * n[1]; q.a[2] += w * n[0] * n[2]; q.a[3] += w * n[0] * d;
+    q.a[4] += w * n[1] * n[1]; q.a[5] += w * n[1] * n[2]; q.a[6] += w * n[1] * d;
+    q.a[7] += w * n[2] * n[2]; q.a[8] += w * n[2] * d;
+    q.a[9] += w * d * d;
+    q.weight += w;
+}
+
+static void addQuadric(Quadric& target, const Quadric& source) {
+    for (int i = 0; i < 10; i++) target.a[i] += source.a[i];
+    target.weight += source.weight;
+}
+
+static double evaluate(const Quadric& q, const float p[3]) {
+    double x = p[0], y = p[1], z = p[2];
+    double e = q.a[0] * x * x + 2.0 * q.a[1] * x * y + 2.0 * q.a[2] * x * z + 2.0 * q.a[3] * x
+             + q.a[4] * y * y + 2.0 * q.a[5] * y * z + 2.0 * q.a[6] * y
+             + q.a[7] * z * z + 2.0 * q.a[8] * z
+             + q.a[9];
+    return e > 0.0 ? e : 0.0;
+}
+
+static void triangleNormal(const float* p0, const float* p1, const float* p2, double n[3]) {
+    double e1[3] = {(double)p1[0] - p0[0], (double)p1[1] - p0[1], (double)p1[2] - p0[2]};
+    double e2[3] = {(double)p2[0] - p0[0], (double)p2[1] - p0[1], (double)p2[2] - p0[2]};
+    n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+struct Collapse {
+    unsigned int from;
+    unsigned int to;
+    double cost;
+};
+
+static bool collapseFlips(const StandardVertex* vertices, const std::vector<unsigned int>& indices,
+                          const std::vector<unsigned int>& adjacencyOffset, const std::vector<unsigned int>& adjacency,
+                          unsigned int from, unsigned int to) {
+    const float* target = vertices[to].position;
+
+    for (unsigned int a = adjacencyOffset[from]; a < adjacencyOffset[from + 1]; a++) {
+        const unsigned int* tri = &indices[adjacency[a] * 3];
+        if (tri[0] == to || tri[1] == to || tri[2] == to) continue;
+
+        const float* p[3];
+        const float* q[3];
+        for (int k = 0; k < 3; k++) {
+            p[k] = vertices[tri[k]].position;
+            q[k] = tri[k] == from ? target : p[k];
+        }
+
+        double before[3], after[3];
+        triangleNormal(p[0], p[1], p[2], before);
+        triangleNormal(q[0], q[1], q[2], after);
+        double lengthBefore = std::sqrt(before[0] * before[0] + before[1] * before[1] + before[2] * before[2]);
+        double lengthAfter = std::sqrt(after[0] * after[0] + after[1] * after[1] + after[2] * after[2]);
+        double dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+
+        // Вырожденный или развернувшийся треугольник
+        if (lengthAfter <= 0.0 || dot <= 0.25 * lengthBefore * lengthAfter) return true;
+    }
+    return false;
+}
+
+float MeshSimplifier::simplify(const StandardVertex* vertices, size_t vertexCount,
+                               const unsigned int* indices, size_t indexCount,
+                               size_t targetIndexCount, std::vector<unsigned int>& out) {
+    out.assign(indices, indices + indexCount);
+    if (indexCount % 3 != 0 || indexCount <= targetIndexCount) return 0.0f;
+
+    std::vector<Quadric> quadrics(vertexCount, Quadric());
+    for (size_t t = 0; t < indexCount / 3; t++) {
+        const float* p0 = vertices[indices[t * 3]].position;
+        const float* p1 = vertices[indices[t * 3 + 1]].position;
+        const float* p2 = vertices[indices[t * 3 + 2]].position;
+
+        double n[3];
+        triangleNormal(p0, p1, p2, n);
+        double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length <= 0.0) continue;
+
+        n[0] /= length; n[1] /= length; n[2] /= length;
+        double d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+        double area = length * 0.5;
+        for (int k = 0; k < 3; k++) addPlane(quadrics[indices[t * 3 + k]], n, d, area);
+    }
+
+    // Рёбра, принадлежащие одному треугольнику - граница или шов: их вершины не двигаем
+    std::vector<uint64_t> edges;
+    edges.reserve(indexCount);
+    for (size_t t = 0; t < indexCount / 3; t++) {
+        for (int k = 0; k < 3; k++) {
+            uint64_t a = indices[t * 3 + k], b = indices[t * 3 + (k + 1) % 3];
+            edges.push_back(a < b ? (a << 32) | b : (b << 32) | a);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    std::vector<char> locked(vertexCount, 0);
+    for (size_t i = 0; i < edges.size();) {
+        size_t j = i;
+        while (j < edges.size() && edges[j] == edges[i]) j++;
+        if (j - i == 1) {
+            locked[(size_t)(edges[i] >> 32)] = 1;
+            locked[(size_t)(edges[i] & 0xFFFFFFFFu)] = 1;
+        }
+        i = j;
+    }
+
+    double maxCost = 0.0;
+    std::vector<unsigned int> adjacencyOffset(vertexCount + 1);
+    std::vector<unsigned int> adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<char> touched(vertexCount);
+    std::vector<unsigned int> remap(vertexCount);
+
+    while (out.size() > targetIndexCount) {
+        size_t triangleCount = out.size() / 3;
+
+        std::fill(adjacencyOffset.begin(), adjacencyOffset.end(), 0);
+        for (unsigned int v : out) adjacencyOffset[v + 1]++;
+        for (size_t v = 0; v < vertexCount; v++) adjacencyOffset[v + 1] += adjacencyOffset[v];
+        adjacency.resize(out.size());
+        std::vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+        for (size_t t = 0; t < triangleCount; t++) {
+            for (int k = 0; k < 3; k++) adjacency[fill[out[t * 3 + k]]++] = (unsigned int)t;
+        }
+
+        edges.clear();
+        for (size_t t = 0; t < triangleCount; t++) {
+            for (int k = 0; k < 3; k++) {
+                uint64_t a = out[t * 3 + k], b = out[t * 3 + (k + 1) % 3];
+                edges.push_back(a < b ? (a << 32) | b : (b << 32) | a);
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        collapses.clear();
+        for (uint64_t edge : edges) {
+            unsigned int a = (unsigned int)(edge >> 32), b = (unsigned int)(edge & 0xFFFFFFFFu);
+            if (locked[a] && locked[b]) continue;
+
+            Quadric q = quadrics[a];
+            addQuadric(q, quadrics[b]);
+            double norm = q.weight > 0.0 ? 1.0 / q.weight : 0.0;
+
+            double costAB = locked[a] ? -1.0 : evaluate(q, vertices[b].position) * norm;
+            double costBA = locked[b] ? -1.0 : evaluate(q, vertices[a].position) * norm;
+
+            Collapse collapse;
+            if (costBA < 0.0 || (costAB >= 0.0 && costAB <= costBA)) {
+                collapse.from = a; collapse.to = b; collapse.cost = costAB;
+            } else {
+                collapse.from = b; collapse.to = a; collapse.cost = costBA;
+            }
+            collapses.push_back(collapse);
+        }
+        if (collapses.empty()) break;
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) {
+            return x.cost < y.cost;
+        });
+
+        std::fill(touched.begin(), touched.end(), 0);
+        for (size_t v = 0; v < vertexCount; v++) remap[v] = (unsigned int)v;
+
+        size_t removeGoal = (out.size() - targetIndexCount) / 3;
+        size_t removed = 0;
+        size_t applied = 0;
+
+        for (const Collapse& collapse : collapses) {
+            if (touched[collapse.from] || touched[collapse.to]) continue;
+            if (collapseFlips(vertices, out, adjacencyOffset, adjacency, collapse.from, collapse.to)) continue;
+
+            remap[collapse.from] = collapse.to;
+            addQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+            touched[collapse.from] = 1;
+            touched[collapse.to] = 1;
+            maxCost = std::max(maxCost, collapse.cost);
+            applied++;
+
+            // Уходят треугольники, содержащие обе вершины ребра
+            for (unsigned int a = adjacencyOffset[collapse.from]; a < adjacencyOffset[collapse.from + 1]; a++) {
+                const unsigned int* tri = &out[adjacency[a] * 3];
+                if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to) removed++;
+            }
+            if (removed >= removeGoal) break;
+        }
+        if (applied == 0) break;
+
+        size_t write = 0;
+        for (size_t t = 0; t < triangleCount; t++) {
+            unsigned int a = remap[out[t * 3]], b = remap[out[t * 3 + 1]], c = remap[out[t * 3 + 2]];
+            if (a == b || b == c || a == c) continue;
+            out[write++] = a;
+            out[write++] = b;
+            out[write++] = c;
+        }
+        out.resize(write);
+    }
+
+    return (float)std::sqrt(maxCost);
+}
+
+void MeshSimplifier::buildLodChain(StandardMesh& mesh, unsigned int levelCount) {
+    mesh.lods.clear();
+    size_t baseIndexCount = mesh.indices.size();
+    if (baseIndexCount == 0 || baseIndexCount % 3 != 0) return;
+
+    MeshLod base = {0, (unsigned int)baseIndexCount, 0.0f};
+    mesh.lods.push_back(base);
+
+    std::vector<unsigned int> lodIndices;
+    size_t previousCount = baseIndexCount;
+    float previousError = 0.0f;
+
+    for (unsigned int level = 1; level < levelCount; level++) {
+        size_t target = (baseIndexCount >> level) / 3 * 3;
+        if (target < 3 * 32) break;
+
+        float error = simplify(mesh.vertexData(), mesh.vertexCount(),
+                               mesh.indices.data(), baseIndexCount, target, lodIndices);
+
+        // Уровень, почти не отличающийся от предыдущего, не нужен
+        if (lodIndices.empty() || lodIndices.size() > previousCount * 9 / 10) break;
+
+        MeshLod lod;
+        lod.indexOffset = (unsigned int)mesh.indices.size();
+        lod.indexCount = (unsigned int)lodIndices.size();
+        lod.error = std::max(error, previousError);
+        mesh.indices.insert(mesh.indices.end(), lodIndices.begin(), lodIndices.end());
+        mesh.lods.push_back(lod);
+
+        previousCount = lodIndices.size();
+        previousError = lod.error;
+    }
+
+    mesh.indices.shrink_to_fit();
+}
@@ -0,0 +1,24 @@
+#ifndef SIMPLIFY_H
+#define SIMPLIFY_H
+
+#include <vector>
+#include <cstddef>
+#include "parser.h"
+
+// Упрощение по квадрикам ошибок (Garland-Heckbert): рёбра схлопываются в
+// существующие вершины, поэтому все уровни LOD делят один вершинный буфер.
+// Граничные вершины и швы UV/нормалей закреплены.
+class MeshSimplifier {
+public:
+    static const unsigned int MAX_LEVELS = MAX_MESH_LODS;
+
+    // Возвращает ошибку результата в единицах модели (среднеквадратичное расстояние до исходных плоскостей)
+    static float simplify(const StandardVertex* vertices, size_t vertexCount,
+                          const unsigned int* indices, size_t indexCount,
+                          size_t targetIndexCount, std::vector<unsigned int>& out);
+
+    // Дописывает уровни 1..N в конец mesh.indices и заполняет mesh.lods
+    static void buildLodChain(StandardMesh& mesh, unsigned int levelCount = MAX_LEVELS);
+};
+
+#endif
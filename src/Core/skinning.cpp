@@ -0,0 +1,98 @@
+#include "skinning.h"
+#include "threadpool.h"
+#include <cmath>
+#include <cstring>
+#include <glm/gtc/type_ptr.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SKINNING_SSE2 1
+#endif
+
+void CpuSkinner::computePalette(const StandardMesh& mesh, const SceneGraph& sceneGraph, const glm::mat4& meshWorld,
+                                std::vector<glm::mat4>& palette) {
+    glm::mat4 worldToMesh = glm::inverse(meshWorld);
+    palette.resize(mesh.bones.size());
+    for (size_t i = 0; i < mesh.bones.size(); i++) {
+        const MeshBone& bone = mesh.bones[i];
+        palette[i] = worldToMesh * sceneGraph.getWorldTransform(bone.node) * bone.offset;
+    }
+}
+
+static inline void writeNormal(float out[3], float x, float y, float z) {
+    float length = std::sqrt(x * x + y * y + z * z);
+    float inverse = length > 0.0f ? 1.0f / length : 0.0f;
+    out[0] = x * inverse;
+    out[1] = y * inverse;
+    out[2] = z * inverse;
+}
+
+void CpuSkinner::skinRange(const StandardMesh& mesh, const glm::mat4* palette, StandardVertex* out,
+                           size_t begin, size_t end) {
+    const StandardVertex* source = mesh.vertexData();
+    const VertexSkin* skin = mesh.skin.data();
+    const float* matrices = glm::value_ptr(palette[0]);
+    const float weightScale = 1.0f / 255.0f;
+
+    for (size_t v = begin; v < end; v++) {
+        const StandardVertex& in = source[v];
+        const VertexSkin& influences = skin[v];
+        StandardVertex& result = out[v];
+
+        uint32_t packedWeights;
+        std::memcpy(&packedWeights, influences.weights, sizeof(packedWeights));
+        if (packedWeights == 0) {
+            result = in;
+            continue;
+        }
+
+#ifdef SKINNING_SSE2
+        // Смешанная матрица по столбцам: сумма w * M по влияниям
+        __m128 c0 = _mm_setzero_ps(), c1 = _mm_setzero_ps(), c2 = _mm_setzero_ps(), c3 = _mm_setzero_ps();
+        for (unsigned int k = 0; k < MAX_BONE_INFLUENCES; k++) {
+            if (influences.weights[k] == 0) continue;
+            const float* m = matrices + (size_t)influences.bones[k] * 16;
+            __m128 w = _mm_set1_ps(influences.weights[k] * weightScale);
+            c0 = _mm_add_ps(c0, _mm_mul_ps(_mm_loadu_ps(m), w));
+            c1 = _mm_add_ps(c1, _mm_mul_ps(_mm_loadu_ps(m + 4), w));
+            c2 = _mm_add_ps(c2, _mm_mul_ps(_mm_loadu_ps(m + 8), w));
+            c3 = _mm_add_ps(c3, _mm_mul_ps(_mm_loadu_ps(m + 12), w));
+        }
+
+        __m128 position = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(in.position[0])),
+                                                _mm_mul_ps(c1, _mm_set1_ps(in.position[1]))),
+                                     _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(in.position[2])), c3));
+        __m128 normal = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(in.normal[0])),
+                                              _mm_mul_ps(c1, _mm_set1_ps(in.normal[1]))),
+                                   _mm_mul_ps(c2, _mm_set1_ps(in.normal[2])));
+
+        float p[4], n[4];
+        _mm_storeu_ps(p, position);
+        _mm_storeu_ps(n, normal);
+        result.position[0] = p[0];
+        result.position[1] = p[1];
+        result.position[2] = p[2];
+        writeNormal(result.normal, n[0], n[1], n[2]);
+#else
+        glm::mat4 blended(0.0f);
+        for (unsigned int k = 0; k < MAX_BONE_INFLUENCES; k++) {
+            if (influences.weights[k] == 0) continue;
+            blended += palette[influences.bones[k]] * (influences.weights[k] * weightScale);
+        }
+        glm::vec4 p = blended * glm::vec4(in.position[0], in.position[1], in.position[2], 1.0f);
+        glm::vec4 n = blended * glm::vec4(in.normal[0], in.normal[1], in.normal[2], 0.0f);
+        result.position[0] = p.x;
+        result.position[1] = p.y;
+        result.position[2] = p.z;
+        writeNormal(result.normal, n.x, n.y, n.z);
+#endif
+        result.texCoords[0] = in.texCoords[0];
+        result.texCoords[1] = in.texCoords[1];
+    }
+}
+
+void CpuSkinner::skin(const StandardMesh& mesh, const glm::mat4* palette, StandardVertex* out) {
+    ThreadPool::shared().parallelForRange(mesh.vertexCount(), RANGE_VERTICES, [&](size_t begin, size_t end) {
+        skinRange(mesh, palette, out, begin, end);
+    });
+}
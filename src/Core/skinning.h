@@ -0,0 +1,26 @@
+#ifndef SKINNING_H
+#define SKINNING_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "parser.h"
+
+// Скинирование на CPU: вершина смешивает до четырёх матриц палитры (SSE2, если есть).
+// Нормали проходят через ту же смешанную матрицу - это точно для костей без неравномерного масштаба
+class CpuSkinner {
+public:
+    // Матрицы костей меша в его собственном пространстве: meshWorld - мировая матрица узла меша
+    static void computePalette(const StandardMesh& mesh, const SceneGraph& sceneGraph, const glm::mat4& meshWorld,
+                               std::vector<glm::mat4>& palette);
+
+    // Вершины [begin, end) bind-позы -> out (тот же индекс); UV копируются как есть
+    static void skinRange(const StandardMesh& mesh, const glm::mat4* palette, StandardVertex* out,
+                          size_t begin, size_t end);
+
+    // Все вершины меша, диапазонами на потоках пула
+    static void skin(const StandardMesh& mesh, const glm::mat4* palette, StandardVertex* out);
+
+    static const size_t RANGE_VERTICES = 4096;
+};
+
+#endif
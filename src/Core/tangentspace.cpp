@@ -0,0 +1,218 @@
+#include "tangentspace.h"
+#include "threadpool.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+static glm::vec3 loadVec3(const float v[3]) {
+    return glm::vec3(v[0], v[1], v[2]);
+}
+
+// Нормаль, близкая к нулю, заменяется осью Y - как раньше при отсутствии нормалей
+static void storeNormal(float out[3], const glm::vec3& sum) {
+    float length = glm::length(sum);
+    glm::vec3 n = length > 1e-20f ? sum / length : glm::vec3(0.0f, 1.0f, 0.0f);
+    out[0] = n.x;
+    out[1] = n.y;
+    out[2] = n.z;
+}
+
+// Угол при каждой вершине треугольника
+static glm::vec3 cornerAngles(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2) {
+    const glm::vec3* p[3] = {&p0, &p1, &p2};
+    glm::vec3 angles;
+    for (int k = 0; k < 3; k++) {
+        glm::vec3 a = *p[(k + 1) % 3] - *p[k];
+        glm::vec3 b = *p[(k + 2) % 3] - *p[k];
+        float lengths = glm::length(a) * glm::length(b);
+        angles[k] = lengths > 0.0f ? std::acos(std::min(1.0f, std::max(-1.0f, glm::dot(a, b) / lengths))) : 0.0f;
+    }
+    return angles;
+}
+
+// Списки смежности: для каждого ключа (группы позиций или вершины) - его углы треугольников
+static void buildCornerLists(const std::vector<uint32_t>& keyOfCorner, size_t keyCount,
+                             std::vector<uint32_t>& start, std::vector<uint32_t>& corners) {
+    start.assign(keyCount + 1, 0);
+    for (uint32_t key : keyOfCorner) start[key + 1]++;
+    for (size_t k = 0; k < keyCount; k++) start[k + 1] += start[k];
+
+    corners.resize(keyOfCorner.size());
+    std::vector<uint32_t> cursor(start.begin(), start.end() - 1);
+    for (size_t c = 0; c < keyOfCorner.size(); c++) {
+        corners[cursor[keyOfCorner[c]]++] = (uint32_t)c;
+    }
+}
+
+struct PositionKey {
+    float p[3];
+    bool operator==(const PositionKey& other) const { return std::memcmp(p, other.p, sizeof(p)) == 0; }
+};
+
+struct PositionKeyHash {
+    size_t operator()(const PositionKey& key) const {
+        uint32_t bits[3];
+        std::memcpy(bits, key.p, sizeof(bits));
+        return (size_t)(bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+    }
+};
+
+void TangentSpace::computeNormals(StandardMesh& mesh, float creaseAngle) {
+    // Вершины из отображённого файла не пишутся
+    if (mesh.mappedVertices || mesh.vertices.empty()) return;
+
+    StandardVertex* vertices = mesh.vertices.data();
+    const unsigned int* indices = mesh.indices.data();
+    size_t vertexCount = mesh.vertices.size();
+    size_t triangleCount = mesh.baseIndexCount() / 3;
+    ThreadPool& pool = ThreadPool::shared();
+
+    std::vector<glm::vec3> faceNormals(triangleCount);
+    std::vector<glm::vec3> angles(triangleCount);
+    pool.parallelForRange(triangleCount, RANGE_TRIANGLES, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++) {
+            glm::vec3 p0 = loadVec3(vertices[indices[t * 3]].position);
+            glm::vec3 p1 = loadVec3(vertices[indices[t * 3 + 1]].position);
+            glm::vec3 p2 = loadVec3(vertices[indices[t * 3 + 2]].position);
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float length = glm::length(n);
+            faceNormals[t] = length > 0.0f ? n / length : glm::vec3(0.0f);
+            angles[t] = cornerAngles(p0, p1, p2);
+        }
+    });
+
+    // Вершины на одной позиции - одна группа: так сглаживаются и меши с вершиной на каждый угол
+    std::vector<uint32_t> groupOfVertex(vertexCount);
+    std::unordered_map<PositionKey, uint32_t, PositionKeyHash> groups;
+    groups.reserve(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) {
+        PositionKey key = {{vertices[v].position[0] + 0.0f, vertices[v].position[1] + 0.0f, vertices[v].position[2] + 0.0f}};
+        groupOfVertex[v] = groups.emplace(key, (uint32_t)groups.size()).first->second;
+    }
+
+    std::vector<uint32_t> groupOfCorner(triangleCount * 3);
+    for (size_t c = 0; c < groupOfCorner.size(); c++) {
+        groupOfCorner[c] = groupOfVertex[indices[c]];
+    }
+    std::vector<uint32_t> groupStart, groupCorners;
+    buildCornerLists(groupOfCorner, groups.size(), groupStart, groupCorners);
+
+    float creaseCos = std::cos(std::min(180.0f, std::max(0.0f, creaseAngle)) * 3.14159265f / 180.0f);
+    pool.parallelForRange(vertexCount, RANGE_VERTICES, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; v++) {
+            uint32_t group = groupOfVertex[v];
+            uint32_t first = groupStart[group], last = groupStart[group + 1];
+
+            // Направление самой вершины - по её собственным граням; неиспользуемая вершина берёт всю группу
+            glm::vec3 own(0.0f), all(0.0f);
+            for (uint32_t i = first; i < last; i++) {
+                uint32_t corner = groupCorners[i];
+                glm::vec3 weighted = faceNormals[corner / 3] * angles[corner / 3][corner % 3];
+                all += weighted;
+                if (indices[corner] == v) own += weighted;
+            }
+            if (glm::dot(own, own) <= 0.0f) own = all;
+            float ownLength = glm::length(own);
+            if (ownLength <= 0.0f) {
+                storeNormal(vertices[v].normal, own);
+                continue;
+            }
+            own /= ownLength;
+
+            glm::vec3 sum(0.0f);
+            for (uint32_t i = first; i < last; i++) {
+                uint32_t corner = groupCorners[i];
+                const glm::vec3& n = faceNormals[corner / 3];
+                if (glm::dot(n, own) >= creaseCos) sum += n * angles[corner / 3][corner % 3];
+            }
+            storeNormal(vertices[v].normal, glm::dot(sum, sum) > 0.0f ? sum : own);
+        }
+    });
+}
+
+void TangentSpace::computeTangents(StandardMesh& mesh) {
+    mesh.tangents.clear();
+    const StandardVertex* vertices = mesh.vertexData();
+    const unsigned int* indices = mesh.indexData();
+    size_t vertexCount = mesh.vertexCount();
+    size_t triangleCount = mesh.baseIndexCount() / 3;
+    if (vertexCount == 0 || triangleCount == 0) return;
+    ThreadPool& pool = ThreadPool::shared();
+
+    // Касательная и битангенс грани - единичные, вес даёт угол при вершине, как в MikkTSpace
+    std::vector<glm::vec3> faceTangents(triangleCount), faceBitangents(triangleCount);
+    std::vector<glm::vec3> angles(triangleCount);
+    std::atomic<bool> mapped(false);
+    pool.parallelForRange(triangleCount, RANGE_TRIANGLES, [&](size_t begin, size_t end) {
+        bool anyMapped = false;
+        for (size_t t = begin; t < end; t++) {
+            const StandardVertex& v0 = vertices[indices[t * 3]];
+            const StandardVertex& v1 = vertices[indices[t * 3 + 1]];
+            const StandardVertex& v2 = vertices[indices[t * 3 + 2]];
+            glm::vec3 p0 = loadVec3(v0.position), p1 = loadVec3(v1.position), p2 = loadVec3(v2.position);
+            glm::vec3 e1 = p1 - p0, e2 = p2 - p0;
+            float du1 = v1.texCoords[0] - v0.texCoords[0], dv1 = v1.texCoords[1] - v0.texCoords[1];
+            float du2 = v2.texCoords[0] - v0.texCoords[0], dv2 = v2.texCoords[1] - v0.texCoords[1];
+            angles[t] = cornerAngles(p0, p1, p2);
+
+            float area = du1 * dv2 - du2 * dv1;
+            glm::vec3 tangent(0.0f), bitangent(0.0f);
+            if (std::fabs(area) > 1e-20f) {
+                // Знак площади UV учитывается делением - зеркальная развёртка даёт отрицательный битангенс
+                tangent = (e1 * dv2 - e2 * dv1) / area;
+                bitangent = (e2 * du1 - e1 * du2) / area;
+                float tangentLength = glm::length(tangent), bitangentLength = glm::length(bitangent);
+                tangent = tangentLength > 0.0f ? tangent / tangentLength : glm::vec3(0.0f);
+                bitangent = bitangentLength > 0.0f ? bitangent / bitangentLength : glm::vec3(0.0f);
+                anyMapped = anyMapped || tangentLength > 0.0f;
+            }
+            faceTangents[t] = tangent;
+            faceBitangents[t] = bitangent;
+        }
+        if (anyMapped) mapped = true;
+    });
+    if (!mapped) return;
+
+    std::vector<uint32_t> vertexOfCorner(indices, indices + triangleCount * 3);
+    std::vector<uint32_t> vertexStart, vertexCorners;
+    buildCornerLists(vertexOfCorner, vertexCount, vertexStart, vertexCorners);
+
+    mesh.tangents.resize(vertexCount);
+    VertexTangent* tangents = mesh.tangents.data();
+    pool.parallelForRange(vertexCount, RANGE_VERTICES, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; v++) {
+            glm::vec3 n = loadVec3(vertices[v].normal);
+            glm::vec3 tangent(0.0f), bitangent(0.0f);
+            for (uint32_t i = vertexStart[v]; i < vertexStart[v + 1]; i++) {
+                uint32_t corner = vertexCorners[i];
+                float weight = angles[corner / 3][corner % 3];
+                // Проекция на плоскость нормали до суммирования, чтобы грани под углом не перевешивали
+                const glm::vec3& t = faceTangents[corner / 3];
+                const glm::vec3& b = faceBitangents[corner / 3];
+                tangent += (t - n * glm::dot(n, t)) * weight;
+                bitangent += (b - n * glm::dot(n, b)) * weight;
+            }
+
+            tangent -= n * glm::dot(n, tangent);
+            float length = glm::length(tangent);
+            if (length > 1e-20f) {
+                tangent /= length;
+            } else {
+                // Вырожденная развёртка: любая ось, перпендикулярная нормали
+                glm::vec3 axis = std::fabs(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+                tangent = glm::cross(axis, n);
+                length = glm::length(tangent);
+                tangent = length > 0.0f ? tangent / length : glm::vec3(1.0f, 0.0f, 0.0f);
+            }
+
+            VertexTangent& out = tangents[v];
+            out.direction[0] = tangent.x;
+            out.direction[1] = tangent.y;
+            out.direction[2] = tangent.z;
+            out.handedness = glm::dot(glm::cross(n, tangent), bitangent) < 0.0f ? -1.0f : 1.0f;
+        }
+    });
+}
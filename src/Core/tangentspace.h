@@ -0,0 +1,24 @@
+#ifndef TANGENTSPACE_H
+#define TANGENTSPACE_H
+
+#include <cstddef>
+#include "parser.h"
+
+// Нормали и касательные меша. Обе стадии считаются параллельно: сначала данные граней
+// по диапазонам треугольников, затем сумма по диапазонам вершин через списки смежности,
+// так что потокам не нужны атомарные сложения.
+class TangentSpace {
+public:
+    // Гладкие нормали с весом по углу грани при вершине. Вершины с одинаковой позицией
+    // сглаживаются вместе, но грань, отклонённая от вершины больше creaseAngle (градусы), не учитывается
+    static void computeNormals(StandardMesh& mesh, float creaseAngle);
+
+    // Касательные в соглашениях MikkTSpace: сумма касательных граней с весом по углу,
+    // ортогонализация к нормали, знак битангенса в w. Без развёртки UV массив остаётся пустым
+    static void computeTangents(StandardMesh& mesh);
+
+    static const size_t RANGE_TRIANGLES = 16384;
+    static const size_t RANGE_VERTICES = 16384;
+};
+
+#endif
@@ -0,0 +1,108 @@
+#include "threadpool.h"
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threadCount) : stopping(false) {
+    if (threadCount == 0) {
+        unsigned int hardware = std::thread::hardware_concurrency();
+        threadCount = hardware > 1 ? hardware - 1 : 1;
+    }
+
+    for (size_t i = 0; i < threadCount; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueCondition.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        tasks.push_back(std::move(task));
+    }
+    queueCondition.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+    parallelForRange(count, 1, [&body](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) body(i);
+    });
+}
+
+void ThreadPool::parallelForRange(size_t count, size_t grainSize,
+                                  const std::function<void(size_t, size_t)>& body) {
+    if (count == 0) return;
+    if (grainSize == 0) grainSize = 1;
+
+    size_t chunkCount = (count + grainSize - 1) / grainSize;
+    if (chunkCount == 1 || workers.empty()) {
+        body(0, count);
+        return;
+    }
+
+    // Состояние живёт, пока его держит хотя бы один помощник из очереди
+    struct Job {
+        std::atomic<size_t> nextChunk{0};
+        std::atomic<size_t> doneChunks{0};
+        std::mutex doneMutex;
+        std::condition_variable doneCondition;
+    };
+    auto job = std::make_shared<Job>();
+    const std::function<void(size_t, size_t)>* bodyPtr = &body;
+
+    auto run = [job, bodyPtr, count, grainSize, chunkCount]() {
+        while (true) {
+            size_t chunk = job->nextChunk.fetch_add(1);
+            if (chunk >= chunkCount) return;
+
+            size_t begin = chunk * grainSize;
+            size_t end = std::min(count, begin + grainSize);
+            (*bodyPtr)(begin, end);
+
+            if (job->doneChunks.fetch_add(1) + 1 == chunkCount) {
+                std::lock_guard<std::mutex> lock(job->doneMutex);
+                job->doneCondition.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min(workers.size(), chunkCount - 1);
+    for (size_t i = 0; i < helpers; i++) {
+        enqueue(run);
+    }
+
+    run();
+
+    std::unique_lock<std::mutex> lock(job->doneMutex);
+    job->doneCondition.wait(lock, [&job, chunkCount] { return job->doneChunks.load() == chunkCount; });
+}
@@ -0,0 +1,41 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstddef>
+
+// Пул рабочих потоков. Вызывающий поток тоже участвует в parallelFor,
+// поэтому вложенные вызовы из задач пула не блокируются.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void enqueue(std::function<void()> task);
+    void parallelFor(size_t count, const std::function<void(size_t)>& body);
+    void parallelForRange(size_t count, size_t grainSize,
+                          const std::function<void(size_t, size_t)>& body);
+
+    size_t getThreadCount() const { return workers.size(); }
+
+    static ThreadPool& shared();
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    bool stopping;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include "uniformbuffer.h"
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+UniformRingBuffer::UniformRingBuffer()
+    : buffer(0), regionSize(0), regionCount(0), region(0), alignment(256), blocks(0) {}
+
+bool UniformRingBuffer::create(size_t regionBytes, size_t count) {
+    destroy();
+
+    GLint offsetAlignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+    if (offsetAlignment > 0) alignment = (size_t)offsetAlignment;
+
+    regionSize = std::max((regionBytes + alignment - 1) / alignment * alignment, alignment);
+    regionCount = count > 0 ? count : 1;
+    region = 0;
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, regionSize * regionCount, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    if (buffer == 0) {
+        std::cout << "Failed to create uniform ring buffer" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void UniformRingBuffer::destroy() {
+    if (buffer != 0) {
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+    regionSize = regionCount = region = blocks = 0;
+    staging.clear();
+}
+
+void UniformRingBuffer::beginFrame() {
+    if (regionCount > 0) region = (region + 1) % regionCount;
+    staging.clear();
+    blocks = 0;
+}
+
+size_t UniformRingBuffer::allocate(const void* data, size_t size) {
+    size_t offset = (staging.size() + alignment - 1) / alignment * alignment;
+    staging.resize(offset + size);
+    std::memcpy(staging.data() + offset, data, size);
+    blocks++;
+    return offset;
+}
+
+void UniformRingBuffer::flush() {
+    if (buffer == 0 || staging.empty()) return;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    if (staging.size() > regionSize) {
+        // Новое хранилище: старое отвязывается, кадры в полёте дочитают его
+        while (regionSize < staging.size()) regionSize *= 2;
+        glBufferData(GL_UNIFORM_BUFFER, regionSize * regionCount, nullptr, GL_DYNAMIC_DRAW);
+        region = 0;
+    }
+    glBufferSubData(GL_UNIFORM_BUFFER, region * regionSize, staging.size(), staging.data());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UniformRingBuffer::bind(GLuint binding, size_t offset, size_t size) const {
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, (GLintptr)(region * regionSize + offset), (GLsizeiptr)size);
+}
@@ -0,0 +1,47 @@
+#ifndef UNIFORMBUFFER_H
+#define UNIFORMBUFFER_H
+
+#include <GL/glew.h>
+#include <vector>
+#include <cstddef>
+
+// Кольцевой UBO для данных, которые меняются каждый кадр. Буфер поделён на области
+// по числу кадров в полёте: кадр пишет в свою область, пока GPU читает предыдущие.
+// Блоки копятся на CPU и уходят одной glBufferSubData во flush; привязка -
+// glBindBufferRange по смещению, которое вернул allocate.
+class UniformRingBuffer {
+public:
+    UniformRingBuffer();
+    UniformRingBuffer(const UniformRingBuffer&) = delete;
+    UniformRingBuffer& operator=(const UniformRingBuffer&) = delete;
+
+    bool create(size_t regionBytes, size_t regionCount = 3);
+    // Удаляет буфер - вызывается при живом контексте
+    void destroy();
+
+    // Следующая область кольца, запись с начала
+    void beginFrame();
+    // Копирует блок и возвращает его смещение внутри кадра, выровненное под GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    size_t allocate(const void* data, size_t size);
+    template <typename T>
+    size_t allocate(const T& block) { return allocate(&block, sizeof(T)); }
+    // Загружает всё записанное за кадр; область, в которую оно не влезло, растёт
+    void flush();
+    // После flush
+    void bind(GLuint binding, size_t offset, size_t size) const;
+
+    size_t getFrameBytes() const { return staging.size(); }
+    size_t getFrameBlocks() const { return blocks; }
+    size_t getCapacity() const { return regionSize * regionCount; }
+
+private:
+    GLuint buffer;
+    size_t regionSize;
+    size_t regionCount;
+    size_t region;
+    size_t alignment;
+    size_t blocks;
+    std::vector<unsigned char> staging;
+};
+
+#endif
@@ -4,6 +4,48 @@
 #include <iostream>
 #include <string>
 #include "Core/interface.h"
+#include "Core/asyncloader.h"
+#include "Core/animator.h"
+#include <algorithm>
+#include <cmath>
+
+// Вызывается, когда фоновая загрузка закончилась и сцена переключилась
+static void onModelReady(Renderer& renderer, ModelParser& parser, bool reloaded) {
+    const auto& meshes = parser.getMeshes();
+    std::cout << "Model loaded successfully!" << std::endl;
+    std::cout << "Number of meshes: " << meshes.size() << std::endl;
+    if (parser.isAnimated()) {
+        std::cout << "Animation clips: " << parser.getAnimations().size() << std::endl;
+    }
+    
+    // При горячей перезагрузке камеру не трогаем. Границы сцены посчитаны при импорте
+    // с учётом матриц узлов - вершины заново не просматриваются
+    const MeshBounds& bounds = parser.getSceneBounds();
+    if (!meshes.empty() && !reloaded && bounds.radius > 0.0f) {
+        std::cout << "Scene bounds:" << std::endl;
+        std::cout << "  X: [" << bounds.min[0] << " to " << bounds.max[0] << "]" << std::endl;
+        std::cout << "  Y: [" << bounds.min[1] << " to " << bounds.max[1] << "]" << std::endl;
+        std::cout << "  Z: [" << bounds.min[2] << " to " << bounds.max[2] << "]" << std::endl;
+        std::cout << "  Bounding sphere radius: " << bounds.radius << " units" << std::endl;
+        
+        // Сфера целиком в поле зрения: отходим от центра против направления взгляда
+        Camera& camera = renderer.getCamera();
+        float halfFov = glm::radians(camera.GetZoom()) * 0.5f;
+        float distance = bounds.radius / std::sin(halfFov);
+        glm::vec3 center(bounds.center[0], bounds.center[1], bounds.center[2]);
+        camera.SetPosition(center - camera.GetFront() * distance);
+    }
+    
+    if (!parser.getKeepCpuCopies()) {
+        parser.releaseCpuData();
+    }
+    parser.printMemoryReport();
+    
+    // Профиль импорта в JSON - для отслеживания регрессий загрузки
+    const ImportProfile& profile = parser.getImportProfile();
+    std::cout << profile.summary() << std::endl;
+    profile.writeJson("import_profile.json");
+}
 
 int main() {
     std::cout << "=== 3D MODEL VIEWER ===" << std::endl;
@@ -29,60 +71,15 @@ int main() {
     std::cout << "This allows viewing vertices at any distance!" << std::endl;
     std::cout << "=======================\n" << std::endl;
     
-    GLuint shaderProgram = initShaders();
-    if (shaderProgram == 0) {
-        std::cout << "Shader compilation failed!" << std::endl;
-        return -1;
-    }
-    std::cout << "Shaders compiled successfully" << std::endl;
-    
     std::string filepath;
     std::cout << "\nEnter path to 3D model (FBX/OBJ/etc): ";
     std::getline(std::cin, filepath);
     
-    ModelParser parser;
+    AsyncModelLoader loader;
+    loader.setHotReload(true);
     if (!filepath.empty()) {
         std::cout << "Loading model..." << std::endl;
-        if (parser.loadModel(filepath)) {
-            const auto& meshes = parser.getMeshes();
-            std::cout << "Model loaded successfully!" << std::endl;
-            std::cout << "Number of meshes: " << meshes.size() << std::endl;
-            
-            if (!meshes.empty()) {
-                const auto& vertices = meshes[0].vertices;
-                if (!vertices.empty()) {
-                    float minX = vertices[0].position[0], maxX = vertices[0].position[0];
-                    float minY = vertices[0].position[1], maxY = vertices[0].position[1];
-                    float minZ = vertices[0].position[2], maxZ = vertices[0].position[2];
-                    
-                    for (const auto& vertex : vertices) {
-                        minX = std::min(minX, vertex.position[0]);
-                        maxX = std::max(maxX, vertex.position[0]);
-                        minY = std::min(minY, vertex.position[1]);
-                        maxY = std::max(maxY, vertex.position[1]);
-                        minZ = std::min(minZ, vertex.position[2]);
-                        maxZ = std::max(maxZ, vertex.position[2]);
-                    }
-                    
-                    std::cout << "Model bounds:" << std::endl;
-                    std::cout << "  X: [" << minX << " to " << maxX << "]" << std::endl;
-                    std::cout << "  Y: [" << minY << " to " << maxY << "]" << std::endl;
-                    std::cout << "  Z: [" << minZ << " to " << maxZ << "]" << std::endl;
-                    
-                    float modelSize = std::max({maxX - minX, maxY - minY, maxZ - minZ});
-                    std::cout << "  Approximate size: " << modelSize << " units" << std::endl;
-                    
-                    if (modelSize > 100.0f) {
-                        std::cout << "Large model detected! Adjusting camera distance..." << std::endl;
-                        glm::vec3 modelCenter((minX + maxX) / 2, (minY + maxY) / 2, (minZ + maxZ) / 2);
-                        renderer.getCamera().SetPosition(modelCenter + glm::vec3(0, 0, modelSize * 2));
-                    }
-                }
-            }
-        } else {
-            std::cout << "Failed to load model: " << filepath << std::endl;
-            return -1;
-        }
+        loader.requestLoad(filepath);
     } else {
         std::cout << "No model specified, running with empty scene" << std::endl;
     }
@@ -101,6 +98,8 @@ int main() {
     std::cout << "\nMODEL:" << std::endl;
     std::cout << "  R - Toggle model rotation" << std::endl;
     std::cout << "  Current: " << (startWithAnimation ? "ROTATING" : "STATIC") << std::endl;
+    std::cout << "  M - Toggle multi-draw indirect"
+              << (renderer.isMultiDrawSupported() ? "" : " (unavailable, GL 4.3 required)") << std::endl;
     std::cout << "\nSYSTEM:" << std::endl;
     std::cout << "  ESC - Exit" << std::endl;
     std::cout << "=================================\n" << std::endl;
@@ -109,6 +108,12 @@ int main() {
     std::cout << "Status updates every 2 seconds in console" << std::endl;
     
     int frameCount = 0;
+    int lastLoadPercent = -1;
+    
+    // Скелетная анимация: клип 0 проигрывается по кругу, скинирование на CPU
+    Animator animator;
+    double lastFrameTime = glfwGetTime();
+    double lastSkinningReport = lastFrameTime;
     
     // СОЗДАЕМ ИНТЕРФЕЙС ПЕРЕД ЦИКЛОМ
     Interface ui;
@@ -120,8 +125,37 @@ int main() {
         
         renderer.beginFrame();
         
-        if (!parser.getMeshes().empty()) {
-            renderer.renderModel(parser, shaderProgram);
+        // Пока новая модель грузится, рисуем предыдущую сцену
+        if (loader.pump(renderer)) {
+            onModelReady(renderer, *loader.getCurrentScene(), loader.wasReload());
+            animator.reset();
+            glfwSetWindowTitle(renderer.getWindow(), "3D Model Viewer");
+        } else if (loader.isLoading()) {
+            int percent = (int)(loader.getProgress() * 100.0f);
+            if (percent != lastLoadPercent) {
+                std::string title = "3D Model Viewer - Loading " + std::to_string(percent) + "%";
+                glfwSetWindowTitle(renderer.getWindow(), title.c_str());
+                lastLoadPercent = percent;
+            }
+        }
+        
+        double now = glfwGetTime();
+        float frameDelta = (float)(now - lastFrameTime);
+        lastFrameTime = now;
+        
+        std::shared_ptr<ModelParser> scene = loader.getCurrentScene();
+        if (scene && !scene->getMeshes().empty()) {
+            if (scene->isAnimated()) {
+                animator.update(*scene, frameDelta);
+                animator.upload(renderer.getMeshCache(), *scene);
+                if (now - lastSkinningReport > 2.0) {
+                    std::cout << animator.summary() << std::endl;
+                    lastSkinningReport = now;
+                }
+            } else {
+                scene->getSceneGraph().updateWorldTransforms();
+            }
+            renderer.renderModel(*scene);
         }
         
         // Рендерим интерфейс поверх 3D
@@ -133,8 +167,6 @@ int main() {
     // Очистка интерфейса
     ui.cleanup();
     
-    glDeleteProgram(shaderProgram);
-    
     std::cout << "\n=== APPLICATION STATISTICS ===" << std::endl;
     std::cout << "Total frames rendered: " << frameCount << std::endl;
     std::cout << "Average FPS: " << (frameCount / glfwGetTime()) << std::endl;